@@ -0,0 +1,260 @@
+// AggregationService.hpp
+//
+// Maintains rolled-up positions and PV01 over configurable hierarchies of books and of products.
+//
+// @class AggregateNode
+// @description Position and PV01 of one node of a hierarchy, such as a book, a desk, a tenor or a sector.
+//
+// @class AggregationHierarchy
+// @description A tree of named nodes stored as a parent-index array. Leaves are books or CUSIPs; each trade delta
+//              is added to its leaf and then to every ancestor by following the parent indices, so the cost of a
+//              trade is the depth of the tree and every node is always current. Leaves that were not configured
+//              are added on first use under a default parent.
+//
+// @class AggregationService
+// @description Applies every trade, amendment and cancellation from TradeBookingService to a book hierarchy
+//              (e.g. book -> desk -> firm) and a product hierarchy (e.g. CUSIP -> tenor -> sector). Any node is
+//              an O(1) read. Keyed on "book:<node>" or "product:<node>". Listeners receive a ProcessUpdate for
+//              every node a trade moves.
+//
+// @methods (AggregationHierarchy)
+// - AddNode: Adds a node under a parent (empty for a root) at a named level.
+// - AddLeaf: Adds a leaf under a parent.
+// - SetDefaultParent: Sets the parent of leaves that appear without being configured.
+// - Leaf: Returns the index of a leaf, adding it under the default parent if it is new.
+// - Apply: Adds a position and PV01 delta to a leaf and all its ancestors.
+// - Find: Returns a node by name, or nullptr.
+// - GetParent: Returns the parent of a node, or nullptr for a root.
+// - GetNodeCount: Returns the number of nodes.
+//
+// @methods (AggregationService)
+// - GetData / TryGet: Retrieves a node by key.
+// - GetBookHierarchy / GetProductHierarchy: Access the hierarchies for configuration.
+// - GetTradeListener: Listener to register on the trade booking service.
+// - AddTrade / AmendTrade / CancelTrade: Apply one trade event as deltas.
+
+#ifndef AGGREGATIONSERVICE_HPP
+#define AGGREGATIONSERVICE_HPP
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "soa.hpp"
+#include "tradebookingservice.hpp"
+#include "BondAnalytics.hpp"
+
+class AggregateNode {
+public:
+    AggregateNode(std::string _name, std::string _level) : name(std::move(_name)), level(std::move(_level)) {}
+
+    const std::string& GetName() const { return name; }
+    const std::string& GetLevel() const { return level; }
+    long GetPosition() const { return position; }
+    double GetPV01() const { return pv01; }
+
+    void Add(long positionDelta, double pv01Delta) {
+        position += positionDelta;
+        pv01 += pv01Delta;
+    }
+
+    friend std::ostream& operator<<(std::ostream& output, const AggregateNode& node) {
+        output << node.level << "," << node.name << "," << node.position << "," << node.pv01;
+        return output;
+    }
+
+private:
+    std::string name;
+    std::string level;
+    long position = 0;
+    double pv01 = 0.0;
+};
+
+class AggregationHierarchy {
+public:
+    static constexpr std::int32_t NIL = -1;
+
+    explicit AggregationHierarchy(std::string _leafLevel) : leafLevel(std::move(_leafLevel)) {}
+
+    // Parents must be added before their children.
+    std::int32_t AddNode(const std::string& name, const std::string& parent, const std::string& level) {
+        if (index.count(name) > 0) {
+            throw std::invalid_argument("Duplicate aggregation node: " + name);
+        }
+        std::int32_t parentIndex = NIL;
+        if (!parent.empty()) {
+            parentIndex = IndexOf(parent);
+            if (parentIndex == NIL) {
+                throw std::invalid_argument("Unknown parent aggregation node: " + parent);
+            }
+        }
+        std::int32_t nodeIndex = static_cast<std::int32_t>(nodes.size());
+        nodes.emplace_back(name, level);
+        parents.push_back(parentIndex);
+        index.emplace(name, nodeIndex);
+        return nodeIndex;
+    }
+
+    std::int32_t AddLeaf(const std::string& name, const std::string& parent) {
+        return AddNode(name, parent, leafLevel);
+    }
+
+    void SetDefaultParent(const std::string& parent) {
+        if (IndexOf(parent) == NIL) {
+            throw std::invalid_argument("Unknown parent aggregation node: " + parent);
+        }
+        defaultParent = parent;
+    }
+
+    // Returns the leaf for a name, adding it under the default parent if it is new.
+    std::int32_t Leaf(const std::string& name) {
+        std::int32_t nodeIndex = IndexOf(name);
+        return nodeIndex != NIL ? nodeIndex : AddLeaf(name, defaultParent);
+    }
+
+    template<typename OnNode>
+    void Apply(std::int32_t leaf, long positionDelta, double pv01Delta, OnNode onNode) {
+        for (std::int32_t i = leaf; i != NIL; i = parents[i]) {
+            nodes[i].Add(positionDelta, pv01Delta);
+            onNode(nodes[i]);
+        }
+    }
+
+    void Apply(std::int32_t leaf, long positionDelta, double pv01Delta) {
+        Apply(leaf, positionDelta, pv01Delta, [](AggregateNode&) {});
+    }
+
+    AggregateNode* Find(std::string_view name) {
+        std::int32_t nodeIndex = IndexOf(name);
+        return nodeIndex != NIL ? &nodes[nodeIndex] : nullptr;
+    }
+
+    const AggregateNode* GetParent(std::string_view name) const {
+        auto it = index.find(std::string(name));
+        if (it == index.end() || parents[it->second] == NIL) return nullptr;
+        return &nodes[parents[it->second]];
+    }
+
+    size_t GetNodeCount() const { return nodes.size(); }
+
+private:
+    std::int32_t IndexOf(std::string_view name) const {
+        auto it = index.find(std::string(name));
+        return it != index.end() ? it->second : NIL;
+    }
+
+    std::string leafLevel;
+    std::string defaultParent;
+    std::deque<AggregateNode> nodes;     // a deque so references handed out stay valid as leaves are added
+    std::vector<std::int32_t> parents;
+    std::unordered_map<std::string, std::int32_t> index;
+};
+
+template<typename T>
+class AggregationTradeListener;
+
+template<typename T>
+class AggregationService : public Service<std::string, AggregateNode> {
+public:
+    AggregationService()
+        : bookHierarchy("book"), productHierarchy("cusip"),
+          tradeListener(std::make_unique<AggregationTradeListener<T>>(this)) {}
+
+    AggregateNode& GetData(std::string key) override {
+        AggregateNode* node = TryGet(key);
+        if (node == nullptr) {
+            throw std::runtime_error("Key not found: " + key);
+        }
+        return *node;
+    }
+
+    AggregateNode* TryGet(std::string_view key) override {
+        if (key.substr(0, 5) == "book:") return bookHierarchy.Find(key.substr(5));
+        if (key.substr(0, 8) == "product:") return productHierarchy.Find(key.substr(8));
+        return nullptr;
+    }
+
+    void OnMessage(AggregateNode& data) override {
+        // Aggregates are derived from trades only.
+    }
+
+    void AddListener(ServiceListener<AggregateNode>* listener) override {
+        listeners.push_back(listener);
+    }
+
+    const std::vector<ServiceListener<AggregateNode>*>& GetListeners() const override {
+        return listeners;
+    }
+
+    AggregationHierarchy& GetBookHierarchy() { return bookHierarchy; }
+    AggregationHierarchy& GetProductHierarchy() { return productHierarchy; }
+    AggregationTradeListener<T>* GetTradeListener() { return tradeListener.get(); }
+
+    void AddTrade(const Trade<T>& trade) {
+        Apply(trade.GetProduct().GetProductId(), trade.GetBook(), trade.GetSignedQuantity());
+    }
+
+    void AmendTrade(const Trade<T>& trade) {
+        const std::string& productId = trade.GetProduct().GetProductId();
+        Apply(productId, trade.GetOriginalBook(), -trade.GetOriginalSignedQuantity());
+        Apply(productId, trade.GetBook(), trade.GetSignedQuantity());
+    }
+
+    void CancelTrade(const Trade<T>& trade) {
+        Apply(trade.GetProduct().GetProductId(), trade.GetBook(), -trade.GetSignedQuantity());
+    }
+
+private:
+    struct ProductLeaf {
+        std::int32_t leaf;
+        double pv01;
+    };
+
+    void Apply(const std::string& productId, const std::string& book, long quantity) {
+        // The PV01 of each product is looked up once, when its leaf is first used.
+        auto it = productLeaves.find(productId);
+        if (it == productLeaves.end()) {
+            it = productLeaves.emplace(productId, ProductLeaf{productHierarchy.Leaf(productId), BondAnalytics::QueryPV01(productId)}).first;
+        }
+        double pv01 = it->second.pv01 * quantity;
+        std::int32_t bookLeaf = bookHierarchy.Leaf(book);
+
+        if (listeners.empty()) {
+            productHierarchy.Apply(it->second.leaf, quantity, pv01);
+            bookHierarchy.Apply(bookLeaf, quantity, pv01);
+            return;
+        }
+        auto notify = [this](AggregateNode& node) {
+            for (auto* listener : listeners) {
+                listener->ProcessUpdate(node);
+            }
+        };
+        productHierarchy.Apply(it->second.leaf, quantity, pv01, notify);
+        bookHierarchy.Apply(bookLeaf, quantity, pv01, notify);
+    }
+
+    AggregationHierarchy bookHierarchy;
+    AggregationHierarchy productHierarchy;
+    std::unordered_map<std::string, ProductLeaf> productLeaves;
+    std::vector<ServiceListener<AggregateNode>*> listeners;
+    std::unique_ptr<AggregationTradeListener<T>> tradeListener;
+};
+
+template<typename T>
+class AggregationTradeListener : public ServiceListener<Trade<T>> {
+public:
+    explicit AggregationTradeListener(AggregationService<T>* _service) : service(_service) {}
+
+    void ProcessAdd(Trade<T>& data) override { service->AddTrade(data); }
+    void ProcessRemove(Trade<T>& data) override { service->CancelTrade(data); }
+    void ProcessUpdate(Trade<T>& data) override { service->AmendTrade(data); }
+
+private:
+    AggregationService<T>* service;
+};
+
+#endif
@@ -6,14 +6,20 @@
 // @class AlgoExecutionService
 // @description This class handles the orchestration of algorithmic execution orders by managing
 //              data storage, listener notifications, and interfacing with a factory to create execution orders.
+//              Depth is the order book depth of the market data feed it listens to.
 //
 // @methods 
 // - GetData: Retrieves execution data by key.
+// - TryGet: Retrieves execution data by key, or nullptr if none exists.
+// - Find: Retrieves the latest execution data for a product, or nullptr if none exists.
 // - OnMessage: Processes incoming messages related to algorithmic execution (not implemented).
 // - AddListener: Adds a listener to observe algorithmic execution events.
 // - GetListeners: Retrieves a list of listeners observing the service.
-// - AlgoExecuteOrder: Creates and processes algorithmic execution orders from an order book.
+// - AlgoExecuteOrder: Creates and processes algorithmic execution orders from an order book, or from the top
+//                     of the book the listener keeps from book deltas.
+// - GetStrategyName: Returns the name of the strategy behind the order factory.
 // - GetAlgoExecutionServiceListener: Retrieves the listener for handling service-specific events.
+// - Reserve: Pre-allocates the order holders for an expected number of book updates.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -24,6 +30,7 @@
 #define ALGOEXECUTIONSERVICE_HPP
 
 #include <map>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
 #include <memory>
@@ -33,24 +40,34 @@
 #include "AlgoExecution.hpp"
 #include "AlgoExecutionServiceListener.hpp"
 #include "IAlgoOrderFactory.hpp"
+#include "TraceRecorder.hpp"
 
-template<typename T>
-class AlgoExecutionService : public IAlgoExecutionService<T>
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class AlgoExecutionService : public IAlgoExecutionService<T, Depth>
 {
 public:
-    AlgoExecutionService(std::unique_ptr<IAlgoOrderFactory<T>> factory) 
-        : algoexecservicelistener(new AlgoExecutionServiceListener<T>(this)), 
+    AlgoExecutionService(std::unique_ptr<IAlgoOrderFactory<T, Depth>> factory) 
+        : algoexecservicelistener(new AlgoExecutionServiceListener<T, Depth>(this)), 
           count(0), orderFactory(std::move(factory))
     {}
 
     virtual ~AlgoExecutionService() = default;
 
     IAlgoExecution<T>& GetData(std::string key) override {
-        auto it = algoExecutionData.find(key);
-        if (it == algoExecutionData.end()) {
+        IAlgoExecution<T>* algoExecution = TryGet(key);
+        if (algoExecution == nullptr) {
             throw std::runtime_error("Key not found");
         }
-        return *(it->second);
+        return *algoExecution;
+    }
+
+    IAlgoExecution<T>* TryGet(std::string_view key) override {
+        auto it = algoExecutionData.find(key);
+        return it != algoExecutionData.end() ? it->second : nullptr;
+    }
+
+    IAlgoExecution<T>* Find(const T& product) {
+        return TryGet(product.GetProductId());
     }
 
     void OnMessage(IAlgoExecution<T>& data) override {
@@ -74,36 +91,54 @@ public:
         return baseListeners;
     }
 
-    void AlgoExecuteOrder(OrderBook<T>& orderBook) override {
-        auto execOrder = orderFactory->CreateExecutionOrder(orderBook, count);
+    void AlgoExecuteOrder(OrderBook<T, Depth>& orderBook) override {
+        TRACE_SPAN("AlgoExecutionService::AlgoExecuteOrder");
+        Execute(orderFactory->CreateExecutionOrder(orderBook, count), orderBook.GetEventTime());
+    }
+
+    void AlgoExecuteOrder(const T& product, const BidOffer& top, long long eventTime) override {
+        TRACE_SPAN("AlgoExecutionService::AlgoExecuteOrder");
+        Execute(orderFactory->CreateExecutionOrder(product, top, count), eventTime);
+    }
+
+    std::string GetStrategyName() const {
+        return orderFactory->GetStrategyName();
+    }
+
+    AlgoExecutionServiceListener<T, Depth>* GetAlgoExecutionServiceListener() {
+        return algoexecservicelistener;
+    }
+
+    void Reserve(size_t expectedOrders) {
+        algoExecutionHolder.reserve(expectedOrders);
+        execOrderHolder.reserve(expectedOrders);
+    }
+
+private:
+    void Execute(std::unique_ptr<ExecutionOrder<T>> execOrder, long long eventTime) {
+        execOrder->SetEventTime(eventTime);
         count++;
 
         auto algoExecutionObj = std::make_unique<AlgoExecution<T>>(*execOrder, BROKERTEC);
 
-        std::string key = execOrder->GetProduct().GetProductId();
-
-        algoExecutionData[key] = algoExecutionObj.get(); 
+        AlgoExecution<T>* algoExecution = algoExecutionObj.get();
+        algoExecutionData.insert_or_assign(execOrder->GetProduct().GetProductId(), algoExecution);
         algoExecutionHolder.push_back(std::move(algoExecutionObj)); 
         execOrderHolder.push_back(std::move(execOrder)); 
 
         for (auto& l : listeners) {
-            l->ProcessAdd(*algoExecutionData[key]);
+            l->ProcessAdd(*algoExecution);
         }
     }
 
-    AlgoExecutionServiceListener<T>* GetAlgoExecutionServiceListener() {
-        return algoexecservicelistener;
-    }
-
-private:
-    std::map<std::string, AlgoExecution<T>*> algoExecutionData;
+    std::map<std::string, AlgoExecution<T>*, std::less<>> algoExecutionData;
     std::vector<std::unique_ptr<AlgoExecution<T>>> algoExecutionHolder;
     std::vector<std::unique_ptr<ExecutionOrder<T>>> execOrderHolder;
     std::vector<ServiceListener<AlgoExecution<T>>*> listeners;
-    AlgoExecutionServiceListener<T>* algoexecservicelistener;
+    AlgoExecutionServiceListener<T, Depth>* algoexecservicelistener;
     long count;
 
-    std::unique_ptr<IAlgoOrderFactory<T>> orderFactory; 
+    std::unique_ptr<IAlgoOrderFactory<T, Depth>> orderFactory; 
 };
 
 #endif
@@ -5,13 +5,14 @@
 //
 // @class AlgoExecutionServiceListener
 // @description This class listens for changes in order books and triggers appropriate methods in the associated
-//              `AlgoExecutionService`. It handles additions, removals, and updates, although only additions
-//              are currently implemented.
+//              `AlgoExecutionService`. Registered as a delta listener, it keeps the top of each product's book
+//              from the changed levels and executes on that, so it never rescans a full book; registered as
+//              a book listener, it executes on each full book.
 //
 // @methods 
 // - ProcessAdd: Processes the addition of new order book data and invokes AlgoExecuteOrder on the service.
 // - ProcessRemove: Placeholder for processing removal of order book data (not implemented).
-// - ProcessUpdate: Placeholder for processing updates to order book data (not implemented).
+// - ProcessUpdate: Applies a book delta to the product's top of book and invokes AlgoExecuteOrder with it.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -24,22 +25,33 @@
 #include "IAlgoExecutionServiceListener.hpp"
 #include "IAlgoExecutionService.hpp"
 #include "marketdataservice.hpp"
+#include <string>
+#include <unordered_map>
 
-template<typename T>
-class AlgoExecutionServiceListener : public IAlgoExecutionServiceListener<T>
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class AlgoExecutionServiceListener : public IAlgoExecutionServiceListener<T, Depth>, public ServiceListener<BookDelta<T>>
 {
 public:
-    explicit AlgoExecutionServiceListener(IAlgoExecutionService<T>* service) : service(service) {}
+    explicit AlgoExecutionServiceListener(IAlgoExecutionService<T, Depth>* service) : service(service) {}
     virtual ~AlgoExecutionServiceListener() = default;
 
-    void ProcessAdd(OrderBook<T> &data) override {
+    void ProcessAdd(OrderBook<T, Depth> &data) override {
         service->AlgoExecuteOrder(data);
     }
-    void ProcessRemove(OrderBook<T> &data) override {}
-    void ProcessUpdate(OrderBook<T> &data) override {}
+    void ProcessRemove(OrderBook<T, Depth> &data) override {}
+    void ProcessUpdate(OrderBook<T, Depth> &data) override {}
+
+    void ProcessAdd(BookDelta<T> &delta) override { ProcessUpdate(delta); }
+    void ProcessRemove(BookDelta<T> &delta) override {}
+    void ProcessUpdate(BookDelta<T> &delta) override {
+        TopOfBook& top = tops[delta.GetProduct().GetProductId()];
+        top.Apply(delta);
+        service->AlgoExecuteOrder(delta.GetProduct(), top.GetBidOffer(), delta.GetEventTime());
+    }
 
 private:
-    IAlgoExecutionService<T>* service;
+    IAlgoExecutionService<T, Depth>* service;
+    std::unordered_map<std::string, TopOfBook> tops;
 };
 
 #endif
@@ -10,11 +10,14 @@
 //
 // @methods 
 // - GetData: Retrieves streaming data by key.
+// - TryGet: Retrieves streaming data by key, or nullptr if none exists.
+// - Find: Retrieves the latest streaming data for a product, or nullptr if none exists.
 // - OnMessage: Placeholder for handling incoming messages (not implemented).
 // - AddListener: Adds listeners to observe streaming events.
 // - GetListeners: Retrieves a list of listeners observing the service.
 // - GetAlgoStreamingListener: Provides access to the associated streaming service listener.
 // - PublishAlgoStream: Publishes new algorithmic streaming data based on pricing information.
+// - Reserve: Pre-allocates the stream holder for an expected number of price updates.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -28,7 +31,9 @@
 #include "AlgoStreamingServiceListener.hpp"
 #include "AlgoStream.hpp"
 #include "PriceStream.hpp"
+#include "TraceRecorder.hpp"
 #include <map>
+#include <string_view>
 #include <vector>
 #include <memory>
 #include <stdexcept>
@@ -45,10 +50,19 @@ public:
     }
     
     IAlgoStream<T>& GetData(std::string key) override {
-        auto it = algoStreamData.find(key);
-        if (it == algoStreamData.end())
+        IAlgoStream<T>* algoStream = TryGet(key);
+        if (algoStream == nullptr)
             throw std::runtime_error("Key not found");
-        return *(it->second);
+        return *algoStream;
+    }
+
+    IAlgoStream<T>* TryGet(std::string_view key) override {
+        auto it = algoStreamData.find(key);
+        return it != algoStreamData.end() ? it->second : nullptr;
+    }
+
+    IAlgoStream<T>* Find(const T& product) {
+        return TryGet(product.GetProductId());
     }
 
     void OnMessage(IAlgoStream<T>& data) override {
@@ -75,7 +89,12 @@ public:
         return algostreamlistener;
     }
 
+    void Reserve(size_t expectedUpdates) {
+        algoStreamHolder.reserve(expectedUpdates);
+    }
+
     void PublishAlgoStream(const Price<T>& price) override {
+        TRACE_SPAN("AlgoStreamingService::PublishAlgoStream");
         T product = price.GetProduct();
         std::string key = product.GetProductId();
         double mid = price.GetMid();
@@ -90,23 +109,21 @@ public:
         PriceStreamOrder bidOrder(bidPrice, visibleQuantity, hiddenQuantity, BID);
         PriceStreamOrder offerOrder(offerPrice, visibleQuantity, hiddenQuantity, OFFER);
 
-        auto priceStream = std::make_unique<PriceStream<T>>(product, bidOrder, offerOrder);
+        auto priceStream = std::make_unique<PriceStream<T>>(product, bidOrder, offerOrder, price.GetEventTime());
         auto algoStream = std::make_unique<AlgoStream<T>>(*priceStream);
 
-        if (algoStreamData.find(key) != algoStreamData.end()) {
-            algoStreamData.erase(key); 
-        }
-        algoStreamData[key] = std::move(algoStreamHolder.emplace_back(std::move(algoStream))).get();
+        AlgoStream<T>* published = algoStreamHolder.emplace_back(std::move(algoStream)).get();
+        algoStreamData.insert_or_assign(key, published);
 
         for (auto& listener : listeners) {
-            listener->ProcessAdd(*(algoStreamData[key]));
+            listener->ProcessAdd(*published);
         }
 
         priceStreamsStorage[key] = std::move(priceStream);
     }
 
 private:
-    std::map<std::string, AlgoStream<T>*> algoStreamData;
+    std::map<std::string, AlgoStream<T>*, std::less<>> algoStreamData;
     std::vector<std::unique_ptr<AlgoStream<T>>> algoStreamHolder; 
     std::map<std::string, std::unique_ptr<PriceStream<T>>> priceStreamsStorage;
     std::vector<ServiceListener<AlgoStream<T>>*> listeners;
@@ -0,0 +1,512 @@
+// BarService.hpp
+//
+// Aggregates prices and trades into per-product OHLC, mid-TWAP and trade-VWAP bars at fixed intervals.
+//
+// @class Bar
+// @description One closed (or in-progress) bar for a product and interval. OHLC and TWAP come from mid prices,
+//              VWAP and volume come from booked trades. A bar with no prices has zero OHLC and TWAP.
+//
+// @class BarRing
+// @description Fixed-capacity ring of closed bars, allocated once per product and interval.
+//
+// @class BarService
+// @description Listens to the pricing and trade booking services. Each event updates the working bar of every
+//              interval in O(1), and rolls it into the product's ring when its time bucket ends. Listeners receive
+//              a ProcessAdd for every closed bar. Keyed on "<productId>:<interval>", e.g. "91282CAV3:1m", which
+//              resolves to the latest closed bar.
+//
+// @class BarKernels
+// @description Bulk bar computation over whole files. Series are held as structure-of-arrays (timestamps and mids
+//              in separate contiguous vectors). A scalar pass finds the bar boundaries with one division per bar;
+//              the time weight of every mid is then a branch-free element-wise loop over doubles, which GCC
+//              vectorizes at -O3 (check with -fopt-info-vec). Each bar's high, low and weighted sum stay ordered
+//              scalar reductions over its slice.
+//              Reads prices.txt or a BookTickStore replay file.
+//
+// @methods (BarService)
+// - GetData / TryGet: Retrieves the latest closed bar by "<productId>:<interval>" key.
+// - AddListener / GetListeners: Registers and lists bar-close listeners.
+// - GetPriceListener / GetTradeListener: Listeners to register on the pricing and trade booking services.
+// - AddPrice / AddTrade: Applies one event at the current clock time.
+// - CloseBars: Closes every working bar whose interval has ended by the given time, or by the clock time.
+// - GetWorkingBar: Returns the in-progress bar of a product and interval.
+// - GetHistory: Returns the ring of closed bars of a product and interval.
+// - Reserve: Pre-sizes the product index.
+//
+// @methods (BarKernels)
+// - LoadPriceFile: Reads prices.txt into one mid series per product.
+// - LoadReplayFile: Reads the tick rows of a replay file into one top-of-book mid series per product.
+// - ComputeMidBars: Computes OHLC and TWAP bars for one series at one interval.
+
+#ifndef BARSERVICE_HPP
+#define BARSERVICE_HPP
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "soa.hpp"
+#include "pricingservice.hpp"
+#include "tradebookingservice.hpp"
+#include "marketdataservice.hpp"
+#include "PriceUtils.hpp"
+#include "TimeUtils.hpp"
+#include "Clocks.hpp"
+
+enum BarInterval { ONE_SECOND_BAR, ONE_MINUTE_BAR, FIVE_MINUTE_BAR, BAR_INTERVAL_COUNT };
+
+constexpr long long BAR_INTERVAL_NANOS[BAR_INTERVAL_COUNT] = { 1000000000LL, 60000000000LL, 300000000000LL };
+
+inline const char* BarIntervalName(BarInterval interval) {
+    static const char* names[BAR_INTERVAL_COUNT] = { "1s", "1m", "5m" };
+    return names[interval];
+}
+
+template<typename T>
+class Bar {
+public:
+    Bar() = default;
+
+    const T& GetProduct() const { return *product; }
+    BarInterval GetInterval() const { return interval; }
+    long long GetStartNanos() const { return startNanos; }
+    long long GetEndNanos() const { return startNanos + BAR_INTERVAL_NANOS[interval]; }
+    double GetOpen() const { return open; }
+    double GetHigh() const { return high; }
+    double GetLow() const { return low; }
+    double GetClose() const { return close; }
+    double GetTwap() const { return twap; }
+    double GetVwap() const { return volume > 0 ? notional / volume : 0.0; }
+    long GetVolume() const { return volume; }
+    long GetPriceCount() const { return priceCount; }
+    long GetTradeCount() const { return tradeCount; }
+
+    template<typename S>
+    friend ostream& operator<<(ostream& output, const Bar<S>& bar);
+
+private:
+    template<typename S>
+    friend class BarService;
+
+    void Start(const T* _product, BarInterval _interval, long long eventNanos) {
+        *this = Bar();
+        product = _product;
+        interval = _interval;
+        startNanos = eventNanos - eventNanos % BAR_INTERVAL_NANOS[_interval];
+    }
+
+    void AddMid(double mid, long long eventNanos) {
+        if (priceCount == 0) {
+            open = high = low = mid;
+            twapFromNanos = eventNanos;
+        } else {
+            twapSum += lastMid * static_cast<double>(std::max(0LL, eventNanos - lastMidNanos));
+            high = std::max(high, mid);
+            low = std::min(low, mid);
+        }
+        close = mid;
+        lastMid = mid;
+        lastMidNanos = eventNanos;
+        ++priceCount;
+    }
+
+    void AddFill(double price, long quantity) {
+        notional += price * quantity;
+        volume += quantity;
+        ++tradeCount;
+    }
+
+    // The last mid is held until the end of the bar.
+    void Finish() {
+        if (priceCount == 0) return;
+        long long end = GetEndNanos();
+        twapSum += lastMid * static_cast<double>(std::max(0LL, end - lastMidNanos));
+        long long span = end - twapFromNanos;
+        twap = span > 0 ? twapSum / static_cast<double>(span) : close;
+    }
+
+    const T* product = nullptr;
+    BarInterval interval = ONE_SECOND_BAR;
+    long long startNanos = 0;
+    double open = 0.0;
+    double high = 0.0;
+    double low = 0.0;
+    double close = 0.0;
+    double twap = 0.0;
+    double notional = 0.0;
+    long volume = 0;
+    long priceCount = 0;
+    long tradeCount = 0;
+
+    double twapSum = 0.0;
+    double lastMid = 0.0;
+    long long lastMidNanos = 0;
+    long long twapFromNanos = 0;
+};
+
+template<typename T>
+ostream& operator<<(ostream& output, const Bar<T>& bar) {
+    output << bar.GetProduct().GetProductId() << "," << BarIntervalName(bar.GetInterval()) << "," << bar.GetStartNanos()
+           << "," << bar.GetOpen() << "," << bar.GetHigh() << "," << bar.GetLow() << "," << bar.GetClose()
+           << "," << bar.GetTwap() << "," << bar.GetVwap() << "," << bar.GetVolume();
+    return output;
+}
+
+template<typename T>
+class BarRing {
+public:
+    explicit BarRing(size_t capacity = 0) : bars(capacity), head(0), count(0) {}
+
+    void Push(const Bar<T>& bar) {
+        if (bars.empty()) return;
+        bars[head] = bar;
+        head = (head + 1) % bars.size();
+        count = std::min(count + 1, bars.size());
+    }
+
+    // back = 0 is the most recently closed bar.
+    const Bar<T>* Get(size_t back) const {
+        if (back >= count) return nullptr;
+        return &bars[(head + bars.size() - 1 - back) % bars.size()];
+    }
+
+    size_t Size() const { return count; }
+    size_t Capacity() const { return bars.size(); }
+
+private:
+    std::vector<Bar<T>> bars;
+    size_t head;
+    size_t count;
+};
+
+template<typename T>
+class BarServicePriceListener;
+
+template<typename T>
+class BarServiceTradeListener;
+
+template<typename T>
+class BarService : public Service<std::string, Bar<T>> {
+public:
+    // clock supplies the event time; history is the number of closed bars kept per product and interval.
+    explicit BarService(size_t _history = 512, const IClock& _clock = RealTimeClock::Instance())
+        : history(_history), clock(_clock),
+          priceListener(new BarServicePriceListener<T>(this)), tradeListener(new BarServiceTradeListener<T>(this)) {}
+
+    ~BarService() {
+        delete priceListener;
+        delete tradeListener;
+    }
+
+    Bar<T>& GetData(std::string key) override {
+        Bar<T>* bar = TryGet(key);
+        if (bar == nullptr) {
+            throw std::runtime_error("Key not found: " + key);
+        }
+        return *bar;
+    }
+
+    Bar<T>* TryGet(std::string_view key) override {
+        std::size_t colon = key.rfind(':');
+        if (colon == std::string_view::npos) return nullptr;
+        ProductBars* bars = FindProduct(key.substr(0, colon));
+        if (bars == nullptr) return nullptr;
+        for (int i = 0; i < BAR_INTERVAL_COUNT; ++i) {
+            if (key.substr(colon + 1) == BarIntervalName(static_cast<BarInterval>(i))) {
+                return const_cast<Bar<T>*>(bars->history[i].Get(0));
+            }
+        }
+        return nullptr;
+    }
+
+    void OnMessage(Bar<T>& data) override {
+        // Bars are derived from prices and trades only.
+    }
+
+    void AddListener(ServiceListener<Bar<T>>* listener) override {
+        listeners.push_back(listener);
+    }
+
+    const std::vector<ServiceListener<Bar<T>>*>& GetListeners() const override {
+        return listeners;
+    }
+
+    BarServicePriceListener<T>* GetPriceListener() { return priceListener; }
+    BarServiceTradeListener<T>* GetTradeListener() { return tradeListener; }
+
+    void AddPrice(const Price<T>& price) {
+        long long now = clock.NowNanos();
+        ProductBars& bars = GetOrCreateProduct(price.GetProduct());
+        for (int i = 0; i < BAR_INTERVAL_COUNT; ++i) {
+            Roll(bars, static_cast<BarInterval>(i), now).AddMid(price.GetMid(), now);
+        }
+    }
+
+    void AddTrade(const Trade<T>& trade) {
+        long long now = clock.NowNanos();
+        ProductBars& bars = GetOrCreateProduct(trade.GetProduct());
+        for (int i = 0; i < BAR_INTERVAL_COUNT; ++i) {
+            Roll(bars, static_cast<BarInterval>(i), now).AddFill(trade.GetPrice(), trade.GetQuantity());
+        }
+    }
+
+    void CloseBars() {
+        CloseBars(clock.NowNanos());
+    }
+
+    void CloseBars(long long nowNanos) {
+        for (auto& bars : products) {
+            for (int i = 0; i < BAR_INTERVAL_COUNT; ++i) {
+                if (bars->open[i] && nowNanos >= bars->working[i].GetEndNanos()) {
+                    Close(*bars, static_cast<BarInterval>(i));
+                }
+            }
+        }
+    }
+
+    const Bar<T>* GetWorkingBar(std::string_view productId, BarInterval interval) const {
+        const ProductBars* bars = FindProduct(productId);
+        return bars != nullptr && bars->open[interval] ? &bars->working[interval] : nullptr;
+    }
+
+    const BarRing<T>* GetHistory(std::string_view productId, BarInterval interval) const {
+        const ProductBars* bars = FindProduct(productId);
+        return bars != nullptr ? &bars->history[interval] : nullptr;
+    }
+
+    void Reserve(size_t productCount) {
+        productIndex.reserve(productCount);
+        products.reserve(productCount);
+    }
+
+private:
+    struct ProductBars {
+        ProductBars(const T& _product, size_t history) : product(_product) {
+            open.fill(false);
+            for (auto& ring : this->history) ring = BarRing<T>(history);
+        }
+
+        T product;
+        std::array<Bar<T>, BAR_INTERVAL_COUNT> working;
+        std::array<bool, BAR_INTERVAL_COUNT> open;
+        std::array<BarRing<T>, BAR_INTERVAL_COUNT> history;
+    };
+
+    ProductBars* FindProduct(std::string_view productId) const {
+        auto it = productIndex.find(std::string(productId));
+        return it != productIndex.end() ? products[it->second].get() : nullptr;
+    }
+
+    // Rings are allocated once, the first time a product is seen.
+    ProductBars& GetOrCreateProduct(const T& product) {
+        auto it = productIndex.find(product.GetProductId());
+        if (it != productIndex.end()) return *products[it->second];
+        productIndex.emplace(product.GetProductId(), products.size());
+        products.push_back(std::make_unique<ProductBars>(product, history));
+        return *products.back();
+    }
+
+    Bar<T>& Roll(ProductBars& bars, BarInterval interval, long long now) {
+        if (bars.open[interval] && now >= bars.working[interval].GetEndNanos()) {
+            Close(bars, interval);
+        }
+        if (!bars.open[interval]) {
+            bars.working[interval].Start(&bars.product, interval, now);
+            bars.open[interval] = true;
+        }
+        return bars.working[interval];
+    }
+
+    void Close(ProductBars& bars, BarInterval interval) {
+        Bar<T>& bar = bars.working[interval];
+        bar.Finish();
+        bars.history[interval].Push(bar);
+        bars.open[interval] = false;
+        for (auto* listener : listeners) {
+            listener->ProcessAdd(bar);
+        }
+    }
+
+    size_t history;
+    const IClock& clock;
+    std::unordered_map<std::string, size_t> productIndex;
+    std::vector<std::unique_ptr<ProductBars>> products;
+    std::vector<ServiceListener<Bar<T>>*> listeners;
+    BarServicePriceListener<T>* priceListener;
+    BarServiceTradeListener<T>* tradeListener;
+};
+
+template<typename T>
+class BarServicePriceListener : public ServiceListener<Price<T>> {
+public:
+    explicit BarServicePriceListener(BarService<T>* _service) : service(_service) {}
+
+    void ProcessAdd(Price<T>& data) override { service->AddPrice(data); }
+    void ProcessRemove(Price<T>& data) override {}
+    void ProcessUpdate(Price<T>& data) override {}
+
+private:
+    BarService<T>* service;
+};
+
+template<typename T>
+class BarServiceTradeListener : public ServiceListener<Trade<T>> {
+public:
+    explicit BarServiceTradeListener(BarService<T>* _service) : service(_service) {}
+
+    void ProcessAdd(Trade<T>& data) override { service->AddTrade(data); }
+    void ProcessRemove(Trade<T>& data) override {}
+    void ProcessUpdate(Trade<T>& data) override {}
+
+private:
+    BarService<T>* service;
+};
+
+// Time-ordered mids for one product, as parallel arrays.
+struct MidSeries {
+    std::vector<long long> times;
+    std::vector<double> mids;
+};
+
+// Bars of one series at one interval, as parallel arrays indexed by bar.
+struct BarSeries {
+    std::vector<long long> starts;
+    std::vector<double> open;
+    std::vector<double> high;
+    std::vector<double> low;
+    std::vector<double> close;
+    std::vector<double> twap;
+    std::vector<long> counts;
+};
+
+class BarKernels {
+public:
+    // prices.txt layout: Timestamp,CUSIP,Bid,Ask,Spread
+    static std::unordered_map<std::string, MidSeries> LoadPriceFile(const std::string& path) {
+        std::unordered_map<std::string, MidSeries> series;
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line); // Skip header
+
+        while (std::getline(in, line)) {
+            std::string_view row(line);
+            std::size_t c1 = row.find(',');
+            std::size_t c2 = row.find(',', c1 + 1);
+            std::size_t c3 = row.find(',', c2 + 1);
+            std::size_t c4 = row.find(',', c3 + 1);
+            if (c4 == std::string_view::npos) continue;
+
+            double bid = PriceUtils::Frac2Price(std::string(row.substr(c2 + 1, c3 - c2 - 1)));
+            double ask = PriceUtils::Frac2Price(std::string(row.substr(c3 + 1, c4 - c3 - 1)));
+            MidSeries& s = series[std::string(row.substr(c1 + 1, c2 - c1 - 1))];
+            s.times.push_back(TimeUtils::ParseTimeNanos(row.substr(0, c1)));
+            s.mids.push_back((bid + ask) / 2.0);
+        }
+        return series;
+    }
+
+    // Tick rows of a BookTickStore replay file, reduced to the top-of-book mid.
+    template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+    static std::unordered_map<std::string, MidSeries> LoadReplayFile(const std::string& path, std::size_t runtimeDepth = DEFAULT_BOOK_DEPTH) {
+        std::unordered_map<std::string, MidSeries> series;
+        OrderBook<T, Depth> scratch;
+        std::ifstream in(path);
+        std::string line;
+
+        while (std::getline(in, line)) {
+            if (line.size() < 2 || line[0] != 'T') continue;
+            std::string_view row = std::string_view(line).substr(2);
+            std::size_t c1 = row.find(',');
+            std::size_t c2 = row.find(',', c1 + 1);
+
+            MarketDataConnector<T, Depth>::ParseRow(row, runtimeDepth, [&](std::string_view) -> OrderBook<T, Depth>& { return scratch; });
+            BidOffer top = scratch.BestBidOffer();
+            MidSeries& s = series[std::string(row.substr(c1 + 1, c2 - c1 - 1))];
+            s.times.push_back(TimeUtils::ParseTimeNanos(row.substr(0, c1)));
+            s.mids.push_back((top.GetBidOrder().GetPrice() + top.GetOfferOrder().GetPrice()) / 2.0);
+        }
+        return series;
+    }
+
+    static BarSeries ComputeMidBars(const MidSeries& series, BarInterval interval) {
+        const long long length = BAR_INTERVAL_NANOS[interval];
+        const size_t n = series.times.size();
+        const long long* times = series.times.data();
+        const double* mids = series.mids.data();
+        BarSeries bars;
+        if (n == 0) return bars;
+
+        // Pass 1: bar boundaries, one division per bar. Times become offsets from the first bar's start so the
+        // remaining passes work on doubles, which are exact for spans under about 100 days.
+        const long long base = times[0] - times[0] % length;
+        std::vector<size_t> begins;
+        std::vector<double> offsets(n);
+        long long barEnd = base;
+        for (size_t i = 0; i < n; ++i) {
+            if (times[i] >= barEnd) {
+                begins.push_back(i);
+                barEnd = times[i] - times[i] % length + length;
+            }
+            offsets[i] = static_cast<double>(times[i] - base);
+        }
+        begins.push_back(n);
+
+        // Pass 2: each mid is held until the next one, or until its bar ends for the last mid of a bar.
+        std::vector<double> until(n);
+        std::copy(offsets.begin() + 1, offsets.end(), until.begin());
+        for (size_t b = 0; b + 1 < begins.size(); ++b) {
+            long long start = times[begins[b]] - times[begins[b]] % length;
+            until[begins[b + 1] - 1] = static_cast<double>(start + length - base);
+        }
+
+        // Pass 3: time-weighted mids, element-wise and branch-free.
+        std::vector<double> weighted(n);
+        const double* from = offsets.data();
+        const double* to = until.data();
+        double* w = weighted.data();
+        for (size_t i = 0; i < n; ++i) {
+            w[i] = mids[i] * (to[i] - from[i]);
+        }
+
+        // Pass 4: one contiguous slice per bar. These are ordered floating-point reductions, which the compiler
+        // keeps scalar unless reassociation is allowed (-ffast-math).
+        const size_t count = begins.size() - 1;
+        bars.starts.reserve(count);
+        bars.open.reserve(count);
+        bars.high.reserve(count);
+        bars.low.reserve(count);
+        bars.close.reserve(count);
+        bars.twap.reserve(count);
+        bars.counts.reserve(count);
+        for (size_t b = 0; b < count; ++b) {
+            size_t begin = begins[b];
+            size_t end = begins[b + 1];
+            double high = mids[begin];
+            double low = mids[begin];
+            double sum = 0.0;
+            for (size_t j = begin; j < end; ++j) {
+                high = mids[j] > high ? mids[j] : high;
+                low = mids[j] < low ? mids[j] : low;
+                sum += w[j];
+            }
+
+            long long start = times[begin] - times[begin] % length;
+            double span = to[end - 1] - from[begin];
+            bars.starts.push_back(start);
+            bars.open.push_back(mids[begin]);
+            bars.high.push_back(high);
+            bars.low.push_back(low);
+            bars.close.push_back(mids[end - 1]);
+            bars.twap.push_back(span > 0 ? sum / span : mids[end - 1]);
+            bars.counts.push_back(static_cast<long>(end - begin));
+        }
+        return bars;
+    }
+};
+
+#endif
@@ -18,6 +18,7 @@
 // - GetParentOrderId: Retrieves the parent order ID if the order is a child order.
 // - IsChildOrder: Indicates whether the order is a child order.
 // - GetProduct: Retrieves the product associated with the order.
+// - GetEventTime / SetEventTime: Event time of the market data that triggered the order, or 0 when unknown.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -47,6 +48,8 @@ public:
     const std::string& GetParentOrderId() const override { return parentOrderId; }
     bool IsChildOrder() const override { return isChildOrder; }
     const T& GetProduct() const override { return product; }
+    long long GetEventTime() const { return eventTime; }
+    void SetEventTime(long long _eventTime) { eventTime = _eventTime; }
 
 protected:
     BaseExecutionOrder(const T& _product, PricingSide _side, std::string _orderId, OrderType _orderType, double _price,
@@ -72,6 +75,7 @@ private:
     long hiddenQuantity;
     std::string parentOrderId;
     bool isChildOrder;
+    long long eventTime = 0;
 };
 
 #endif
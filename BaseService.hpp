@@ -10,6 +10,7 @@
 //
 // @methods 
 // - GetData: Retrieves the data associated with a given key.
+// - TryGet: Retrieves the data associated with a given key, or nullptr if none exists.
 // - OnMessage: Processes incoming messages (default implementation is a no-op).
 // - AddListener: Adds a listener to observe changes in the service.
 // - GetListeners: Retrieves a list of registered listeners.
@@ -29,6 +30,7 @@
 
 #include "soa.hpp"
 #include <map>
+#include <string_view>
 #include <vector>
 #include <stdexcept>
 
@@ -38,11 +40,16 @@ public:
     virtual ~BaseService() = default;
 
     Value& GetData(Key key) override {
-        auto it = dataMap.find(key);
-        if (it == dataMap.end()) {
+        Value* value = TryGet(key);
+        if (value == nullptr) {
             throw std::runtime_error("Key not found");
         }
-        return it->second;
+        return *value;
+    }
+
+    Value* TryGet(std::string_view key) override {
+        auto it = dataMap.find(key);
+        return it != dataMap.end() ? &it->second : nullptr;
     }
 
     void OnMessage(Value& data) override {
@@ -58,7 +65,7 @@ public:
     }
 
 protected:
-    std::map<Key, Value> dataMap; 
+    std::map<Key, Value, std::less<>> dataMap; 
     std::vector<ServiceListener<Value>*> listeners;
 };
 
@@ -43,6 +43,21 @@ public:
     }
 
     static double QueryPV01(const std::string& cusip) {
+        const auto& pv01Table = GetPV01Table();
+        auto it = pv01Table.find(cusip);
+        if (it == pv01Table.end()) {
+            throw std::invalid_argument("Unknown CUSIP: " + cusip);
+        }
+        return it->second;
+    }
+
+    // Evaluates the PV01 table ahead of the first query.
+    static void Preload() {
+        GetPV01Table();
+    }
+
+private:
+    static const std::map<std::string, double>& GetPV01Table() {
         static const std::map<std::string, std::function<double()>> pv01Map = {
             {"91282CAV3", [] { return CalculatePV01(1000, 0.04500, 0.0464, 2, 2); }},
             {"91282CBL4", [] { return CalculatePV01(1000, 0.04750, 0.0440, 3, 2); }},
@@ -53,11 +68,14 @@ public:
             {"912810TL2", [] { return CalculatePV01(1000, 0.05375, 0.0443, 30, 2); }}
         };
 
-        auto it = pv01Map.find(cusip);
-        if (it == pv01Map.end()) {
-            throw std::invalid_argument("Unknown CUSIP: " + cusip);
-        }
-        return it->second();
+        static const std::map<std::string, double> pv01Table = [] {
+            std::map<std::string, double> table;
+            for (const auto& [cusip, calc] : pv01Map) {
+                table.emplace(cusip, calc());
+            }
+            return table;
+        }();
+        return pv01Table;
     }
 };
 
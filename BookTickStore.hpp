@@ -0,0 +1,256 @@
+// BookTickStore.hpp
+//
+// Records order book updates into a replay file with periodic full-book checkpoints, and replays them from any time.
+//
+// @class BookTickStore
+// @description Appends each book update to a replay file as a tick row. Every N updates, or whenever T seconds of
+//              event time have passed, it also writes a checkpoint block holding the full book of every product.
+//              Each checkpoint's event time and byte offset go into a side index (`<file>.idx`).
+//
+// @class BookReplayer
+// @description Loads the index of a replay file and rebuilds the books as of any timestamp. It binary-searches the
+//              index for the last checkpoint at or before the target, loads it, and applies the short tail of ticks
+//              up to the target. The cost of a seek is bounded by the checkpoint spacing, not the file length.
+//
+// @format
+// - T,<timestamp>,<CUSIP>,<Bid1>,<BidSize1>,<Ask1>,<AskSize1>,...   one book update
+// - S,<timestamp>,<bookCount>                                          checkpoint header, followed by
+// - B,<timestamp>,<CUSIP>,<Bid1>,<BidSize1>,<Ask1>,<AskSize1>,...   one row per book in the checkpoint
+// - <file>.idx holds "<eventTimeNanos>,<byteOffset>" for each checkpoint header.
+//   Ticks are expected in event-time order, as a live feed delivers them. The store counts ticks stamped before
+//   the previous one, since a seek cannot be trusted on a file that has any.
+//
+// @methods (BookTickStore)
+// - Record: Appends one update and writes a checkpoint when one is due.
+// - Checkpoint: Writes a checkpoint immediately.
+// - GetTickCount: Returns the number of updates recorded.
+// - GetCheckpointCount: Returns the number of checkpoints written.
+// - GetOutOfOrderCount: Returns the number of ticks stamped before the tick recorded before them.
+//
+// @methods (BookReplayer)
+// - SeekTo: Rebuilds every book as of a timestamp and returns the number of tail ticks applied.
+// - ScanTo: Rebuilds every book as of a timestamp from every tick in the file, ignoring the checkpoints and the
+//   order of the ticks; a reference for checking SeekTo. Returns the number of ticks applied.
+// - Replay: Publishes the current books and then every tick up to a timestamp into a MarketDataService.
+// - GetBook: Returns the book of a product at the current replay position, or nullptr.
+// - GetBooks: Returns every book at the current replay position.
+// - SameLevels: Returns whether two books have the same prices and sizes on every level.
+
+#ifndef BOOKTICKSTORE_HPP
+#define BOOKTICKSTORE_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "marketdataservice.hpp"
+#include "TimeUtils.hpp"
+
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class BookTickStore {
+public:
+    using Book = OrderBook<T, Depth>;
+
+    BookTickStore(const std::string& replayFile, long _checkpointEvery = 10000, double _checkpointSeconds = 60.0)
+        : out(replayFile, std::ios::binary | std::ios::trunc),
+          index(replayFile + ".idx", std::ios::trunc),
+          checkpointEvery(_checkpointEvery),
+          checkpointNanos(static_cast<long long>(_checkpointSeconds * 1e9)),
+          sinceCheckpoint(0), lastCheckpointNanos(0), lastTickNanos(0), hasCheckpoint(false), tickCount(0),
+          checkpointCount(0), outOfOrderCount(0) {}
+
+    ~BookTickStore() {
+        out.flush();
+        index.flush();
+    }
+
+    void Record(std::string_view timestamp, const Book& orderBook) {
+        long long eventNanos = TimeUtils::ParseTimeNanos(timestamp);
+        if (tickCount > 0 && eventNanos < lastTickNanos) {
+            ++outOfOrderCount;
+        }
+        lastTickNanos = eventNanos;
+
+        const std::string& productId = orderBook.GetProduct().GetProductId();
+        auto it = books.find(productId);
+        if (it == books.end()) {
+            books.emplace(productId, orderBook);
+        } else {
+            it->second.GetBidStack() = orderBook.GetBidStack();
+            it->second.GetOfferStack() = orderBook.GetOfferStack();
+            it->second.SetEventTime(orderBook.GetEventTime());
+        }
+
+        out << "T," << timestamp << ',';
+        MarketDataConnector<T, Depth>::WriteRow(out, orderBook);
+        out << '\n';
+        ++tickCount;
+        ++sinceCheckpoint;
+
+        if (!hasCheckpoint || sinceCheckpoint >= checkpointEvery || eventNanos - lastCheckpointNanos >= checkpointNanos) {
+            Checkpoint(timestamp, eventNanos);
+        }
+    }
+
+    void Checkpoint(std::string_view timestamp, long long eventNanos) {
+        index << eventNanos << ',' << static_cast<long long>(out.tellp()) << '\n';
+        out << "S," << timestamp << ',' << books.size() << '\n';
+        for (const auto& [productId, orderBook] : books) {
+            out << "B," << timestamp << ',';
+            MarketDataConnector<T, Depth>::WriteRow(out, orderBook);
+            out << '\n';
+        }
+        out.flush();
+        index.flush();
+
+        sinceCheckpoint = 0;
+        lastCheckpointNanos = eventNanos;
+        hasCheckpoint = true;
+        ++checkpointCount;
+    }
+
+    long GetTickCount() const { return tickCount; }
+    long GetCheckpointCount() const { return checkpointCount; }
+    long GetOutOfOrderCount() const { return outOfOrderCount; }
+
+private:
+    std::ofstream out;
+    std::ofstream index;
+    std::unordered_map<std::string, Book> books;
+    long checkpointEvery;
+    long long checkpointNanos;
+    long sinceCheckpoint;
+    long long lastCheckpointNanos;
+    long long lastTickNanos;
+    bool hasCheckpoint;
+    long tickCount;
+    long checkpointCount;
+    long outOfOrderCount;
+};
+
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class BookReplayer {
+public:
+    using Book = OrderBook<T, Depth>;
+
+    // runtimeDepth is only used when Depth is DYNAMIC_DEPTH.
+    explicit BookReplayer(const std::string& replayFile, std::size_t _runtimeDepth = DEFAULT_BOOK_DEPTH)
+        : in(replayFile, std::ios::binary), runtimeDepth(_runtimeDepth), position(0) {
+        std::ifstream indexFile(replayFile + ".idx");
+        std::string line;
+        while (std::getline(indexFile, line)) {
+            std::size_t comma = line.find(',');
+            if (comma == std::string::npos) continue;
+            checkpoints.emplace_back(std::stoll(line.substr(0, comma)), std::stoll(line.substr(comma + 1)));
+        }
+    }
+
+    size_t SeekTo(long long timestampNanos) {
+        books.clear();
+        in.clear();
+
+        // Last checkpoint at or before the target; with none, the tail starts at the top of the file.
+        auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), timestampNanos,
+                                   [](long long t, const std::pair<long long, long long>& c) { return t < c.first; });
+        in.seekg(it == checkpoints.begin() ? 0 : std::prev(it)->second);
+
+        size_t applied = 0;
+        Advance(timestampNanos, [&](Book&) { ++applied; });
+        position = timestampNanos;
+        return applied;
+    }
+
+    size_t ScanTo(long long timestampNanos) {
+        books.clear();
+        in.clear();
+        in.seekg(0);
+
+        size_t applied = 0;
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.size() < 2 || line[0] != 'T') continue;
+            std::string_view row(line);
+            std::size_t timeEnd = row.find(',', 2);
+            if (TimeUtils::ParseTimeNanos(row.substr(2, timeEnd - 2)) > timestampNanos) continue;
+            MarketDataConnector<T, Depth>::ParseRow(row.substr(2), runtimeDepth,
+                                                    [this](std::string_view productId) -> Book& { return BookFor(productId); });
+            ++applied;
+        }
+        in.clear();
+        position = timestampNanos;
+        return applied;
+    }
+
+    static bool SameLevels(const Book& a, const Book& b) {
+        auto same = [](const auto& x, const auto& y) {
+            return std::equal(x.begin(), x.end(), y.begin(), y.end(), [](const Order& l, const Order& r) {
+                return l.GetPrice() == r.GetPrice() && l.GetQuantity() == r.GetQuantity();
+            });
+        };
+        return same(a.GetBidStack(), b.GetBidStack()) && same(a.GetOfferStack(), b.GetOfferStack());
+    }
+
+    // Brings service up to date with the books at the current position, then streams every tick up to untilNanos.
+    size_t Replay(long long untilNanos, MarketDataService<T, Depth>& service) {
+        for (auto& [productId, orderBook] : books) {
+            service.OnMessage(orderBook);
+        }
+        size_t published = 0;
+        Advance(untilNanos, [&](Book& orderBook) { service.OnMessage(orderBook); ++published; });
+        position = untilNanos;
+        return published;
+    }
+
+    const Book* GetBook(std::string_view productId) const {
+        auto it = books.find(std::string(productId));
+        return it != books.end() ? &it->second : nullptr;
+    }
+
+    const std::unordered_map<std::string, Book>& GetBooks() const { return books; }
+    long long GetPosition() const { return position; }
+
+private:
+    // Applies rows until the first one stamped after untilNanos, which is left unread for the next call.
+    template<typename OnTick>
+    void Advance(long long untilNanos, OnTick onTick) {
+        std::string line;
+        while (true) {
+            std::streampos start = in.tellg();
+            if (!std::getline(in, line) || line.size() < 2) break;
+
+            std::string_view row(line);
+            std::size_t timeEnd = row.find(',', 2);
+            long long eventNanos = TimeUtils::ParseTimeNanos(row.substr(2, timeEnd - 2));
+            if (eventNanos > untilNanos) {
+                in.clear();
+                in.seekg(start);
+                break;
+            }
+
+            // Checkpoint headers carry no levels; the B rows that follow restore each book.
+            if (row[0] == 'S') continue;
+            Book& orderBook = MarketDataConnector<T, Depth>::ParseRow(row.substr(2), runtimeDepth,
+                                                                      [this](std::string_view productId) -> Book& { return BookFor(productId); });
+            if (row[0] == 'T') onTick(orderBook);
+        }
+    }
+
+    Book& BookFor(std::string_view productId) {
+        auto it = books.find(std::string(productId));
+        if (it == books.end()) {
+            it = books.emplace(std::string(productId), Book(ProductFactory<T>::QueryProduct(std::string(productId)), {}, {})).first;
+        }
+        return it->second;
+    }
+
+    std::ifstream in;
+    std::size_t runtimeDepth;
+    long long position;
+    std::vector<std::pair<long long, long long>> checkpoints;
+    std::unordered_map<std::string, Book> books;
+};
+
+#endif
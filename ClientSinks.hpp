@@ -0,0 +1,101 @@
+// ClientSinks.hpp
+//
+// Destinations for encoded outbound messages, shared by the streaming gateway and the FIX order sender.
+//
+// @class IClientSink
+// @description Destination of encoded messages for one client or venue, such as a socket or a file.
+//
+// @class FileClientSink
+// @description Appends messages to a file.
+//
+// @class SocketClientSink
+// @description Writes messages to a connected socket or pipe file descriptor, which it does not own. Interrupted
+//              writes are retried until the whole message is out. A client that stops reading loses the message
+//              that would block, as long as none of it was written, so the stream stays on a message boundary.
+//              A message cut short, or a closed peer, disconnects the client; later messages are dropped.
+//              Sockets are written with MSG_NOSIGNAL; for pipes SIGPIPE is ignored process-wide, so a reader
+//              that goes away surfaces as EPIPE instead of killing the process.
+
+#ifndef CLIENTSINKS_HPP
+#define CLIENTSINKS_HPP
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <cerrno>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class IClientSink {
+public:
+    virtual ~IClientSink() = default;
+    virtual void Write(std::string_view message) = 0;
+};
+
+class FileClientSink : public IClientSink {
+public:
+    explicit FileClientSink(const std::string& path) : out(path, std::ios::binary | std::ios::app) {
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open client sink file: " + path);
+        }
+    }
+
+    void Write(std::string_view message) override {
+        out.write(message.data(), static_cast<std::streamsize>(message.size()));
+    }
+
+private:
+    std::ofstream out;
+};
+
+class SocketClientSink : public IClientSink {
+public:
+    explicit SocketClientSink(int _fd) : fd(_fd) {
+        struct stat info;
+        isSocket = ::fstat(fd, &info) == 0 && S_ISSOCK(info.st_mode);
+        if (!isSocket) {
+            std::signal(SIGPIPE, SIG_IGN);
+        }
+    }
+
+    void Write(std::string_view message) override {
+        if (!connected) {
+            ++dropped;
+            return;
+        }
+        // A client that stops reading loses messages instead of stalling the other clients.
+        const char* data = message.data();
+        size_t remaining = message.size();
+        while (remaining > 0) {
+            ssize_t written = isSocket ? ::send(fd, data, remaining, MSG_NOSIGNAL) : ::write(fd, data, remaining);
+            if (written > 0) {
+                data += written;
+                remaining -= static_cast<size_t>(written);
+                continue;
+            }
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            ++dropped;
+            bool wouldBlock = written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            if (!wouldBlock || remaining != message.size()) {
+                connected = false;
+            }
+            return;
+        }
+    }
+
+    long GetDroppedCount() const { return dropped; }
+    bool IsConnected() const { return connected; }
+
+private:
+    int fd;
+    bool isSocket = false;
+    bool connected = true;
+    long dropped = 0;
+};
+
+#endif
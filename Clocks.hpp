@@ -0,0 +1,77 @@
+// Clocks.hpp
+//
+// Implements the IClock interface for live runs, replays and tests.
+//
+// @class RealTimeClock
+// @description Reads the system clock. This is the default clock of every service.
+//
+// @class EventTimeClock
+// @description Follows the timestamps of the input. Connectors advance it as they read each message, and it
+//              never moves backwards, so out-of-order rows do not rewind timers.
+//
+// @class ManualClock
+// @description Only moves when told to, for tests and step-by-step simulations.
+//
+// @methods (RealTimeClock)
+// - Instance: Returns the shared real-time clock.
+//
+// @methods (EventTimeClock)
+// - Advance: Moves the clock to an event time, if it is later than the current one.
+// - HasStarted: Returns whether any event has been seen.
+//
+// @methods (ManualClock)
+// - Set: Sets the current time.
+// - AdvanceBy: Moves the clock forward by a duration.
+
+#ifndef CLOCKS_HPP
+#define CLOCKS_HPP
+
+#include <chrono>
+#include "IClock.hpp"
+
+class RealTimeClock : public IClock {
+public:
+    long long NowNanos() const override {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static RealTimeClock& Instance() {
+        static RealTimeClock clock;
+        return clock;
+    }
+};
+
+class EventTimeClock : public IClock {
+public:
+    explicit EventTimeClock(long long _startNanos = 0) : now(_startNanos), started(false) {}
+
+    long long NowNanos() const override { return now; }
+
+    void Advance(long long eventNanos) {
+        if (eventNanos > now) {
+            now = eventNanos;
+        }
+        started = true;
+    }
+
+    bool HasStarted() const { return started; }
+
+private:
+    long long now;
+    bool started;
+};
+
+class ManualClock : public IClock {
+public:
+    explicit ManualClock(long long _startNanos = 0) : now(_startNanos) {}
+
+    long long NowNanos() const override { return now; }
+
+    void Set(long long nanos) { now = nanos; }
+    void AdvanceBy(long long nanos) { now += nanos; }
+
+private:
+    long long now;
+};
+
+#endif
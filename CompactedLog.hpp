@@ -0,0 +1,296 @@
+// CompactedLog.hpp
+//
+// A segmented, append-only record log that is compacted in the background to the latest record per key.
+//
+// @class CompactedLog
+// @description Records are appended as "<key>\t<payload>\n" to the active segment file. Once the active segment
+//              reaches its size limit it is closed and a new one is started. A background thread then compacts
+//              every closed segment except the newest few: it rewrites them into one segment holding only the
+//              last record of each key, and swaps that in for its inputs. The active segment and the newest
+//              closed segments therefore keep the full recent history, while older history shrinks to one record
+//              per key, so storage stays proportional to the number of keys. An index maps each key to the file
+//              offset of its latest record, so a latest-state read is a single seek. On start the log reopens
+//              segments left in its directory and rebuilds the index from them, and deletes the temporary file of
+//              a compaction that was cut short.
+//              Appends come from one writer thread; the index and segment list are shared with the compactor
+//              under a mutex, and the compactor does its file reads and writes outside it.
+//
+// @methods
+// - Append: Appends one record for a key.
+// - ReadLatest: Reads the latest payload of a key; false if the key has no record.
+// - Compact: Compacts eligible closed segments on the calling thread (the compactor calls it on every roll).
+// - GetSegmentCount: Returns the number of segment files, including the active one.
+// - GetCompactionCount: Returns the number of compactions completed.
+// - GetKeyCount: Returns the number of keys indexed.
+// - GetDiskBytes: Returns the total size of the segment files.
+
+#ifndef COMPACTEDLOG_HPP
+#define COMPACTEDLOG_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CompactedLog {
+public:
+    // historySegments closed segments are kept uncompacted behind the active one.
+    CompactedLog(std::string _directory, std::string _name, std::uint64_t _segmentBytes = 1 << 20, size_t _historySegments = 1)
+        : directory(std::move(_directory)), name(std::move(_name)), segmentBytes(_segmentBytes), historySegments(_historySegments) {
+        if (segmentBytes == 0) {
+            throw std::invalid_argument("Compacted log segments must have a positive size");
+        }
+        std::filesystem::create_directories(directory);
+        Recover();
+        active = Segment{nextId++, 0, false};
+        out.open(SegmentPath(active.id), std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Cannot open log segment: " + SegmentPath(active.id));
+        }
+        compactor = std::thread([this]() { CompactorLoop(); });
+    }
+
+    ~CompactedLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        compactor.join();
+        out.close();
+    }
+
+    CompactedLog(const CompactedLog&) = delete;
+    CompactedLog& operator=(const CompactedLog&) = delete;
+
+    void Append(const std::string& key, std::string_view payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        out.write(key.data(), static_cast<std::streamsize>(key.size()));
+        out.put('\t');
+        out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        out.put('\n');
+        index[key] = Location{active.id, active.bytes + key.size() + 1, payload.size()};
+        active.bytes += key.size() + payload.size() + 2;
+
+        if (active.bytes >= segmentBytes) {
+            out.close();
+            closed.push_back(active);
+            active = Segment{nextId++, 0, false};
+            out.open(SegmentPath(active.id), std::ios::binary | std::ios::trunc);
+            pending = true;
+            wake.notify_one();
+        }
+    }
+
+    bool ReadLatest(const std::string& key, std::string& payload) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return false;
+        }
+        const Location& location = it->second;
+        if (location.segment == active.id) {
+            out.flush();
+        }
+        std::ifstream in(SegmentPath(location.segment), std::ios::binary);
+        in.seekg(static_cast<std::streamoff>(location.offset));
+        payload.resize(location.length);
+        in.read(payload.data(), static_cast<std::streamsize>(location.length));
+        return static_cast<bool>(in);
+    }
+
+    void Compact() {
+        std::lock_guard<std::mutex> compacting(compactMutex);
+        std::vector<Segment> inputs;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed.size() <= historySegments) return;
+            inputs.assign(closed.begin(), closed.end() - static_cast<std::ptrdiff_t>(historySegments));
+        }
+        if (inputs.size() == 1 && inputs.front().compacted) return;
+
+        // Keys keep the order of their first appearance; later records overwrite earlier ones.
+        std::vector<std::string> keys;
+        std::unordered_map<std::string, std::string> latest;
+        for (const Segment& segment : inputs) {
+            ReadSegment(SegmentPath(segment.id), [&](std::string key, std::string payload, std::uint64_t) {
+                auto [it, inserted] = latest.try_emplace(std::move(key), std::move(payload));
+                if (inserted) {
+                    keys.push_back(it->first);
+                } else {
+                    it->second = std::move(payload);
+                }
+            });
+        }
+
+        Segment output{inputs.back().id, 0, true};
+        std::string temporary = SegmentPath(output.id) + ".compacting";
+        std::vector<std::pair<const std::string*, Location>> locations;
+        locations.reserve(keys.size());
+        {
+            std::ofstream compactedFile(temporary, std::ios::binary | std::ios::trunc);
+            for (const std::string& key : keys) {
+                const std::string& payload = latest[key];
+                compactedFile << key << '\t' << payload << '\n';
+                locations.emplace_back(&key, Location{output.id, output.bytes + key.size() + 1, payload.size()});
+                output.bytes += key.size() + payload.size() + 2;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        std::filesystem::rename(temporary, SegmentPath(output.id));
+        for (size_t i = 0; i + 1 < inputs.size(); ++i) {
+            std::filesystem::remove(SegmentPath(inputs[i].id));
+        }
+        // Inputs are the oldest segments, so an index entry at or below the output id still points into them.
+        for (const auto& [key, location] : locations) {
+            auto it = index.find(*key);
+            if (it != index.end() && it->second.segment <= output.id) {
+                it->second = location;
+            }
+        }
+        closed.erase(closed.begin(), closed.begin() + static_cast<std::ptrdiff_t>(inputs.size()));
+        closed.push_front(output);
+        ++compactions;
+    }
+
+    size_t GetSegmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return closed.size() + 1;
+    }
+
+    long GetCompactionCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return compactions;
+    }
+
+    size_t GetKeyCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index.size();
+    }
+
+    std::uint64_t GetDiskBytes() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::uint64_t bytes = active.bytes;
+        for (const Segment& segment : closed) bytes += segment.bytes;
+        return bytes;
+    }
+
+private:
+    struct Segment {
+        std::uint64_t id;
+        std::uint64_t bytes;
+        bool compacted;
+    };
+
+    struct Location {
+        std::uint64_t segment;
+        std::uint64_t offset;
+        std::uint64_t length;
+    };
+
+    std::string SegmentPath(std::uint64_t id) const {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%012llu.log", static_cast<unsigned long long>(id));
+        return directory + "/" + name + suffix;
+    }
+
+    // Calls onRecord(key, payload, offset of the line) for every record. Lines without a tab, such as a record cut
+    // short by a crash, are skipped but still counted, so the offsets of the records after them stay right.
+    template<typename OnRecord>
+    static std::uint64_t ReadSegment(const std::string& path, OnRecord onRecord) {
+        std::ifstream in(path, std::ios::binary);
+        std::string line;
+        std::uint64_t bytes = 0;
+        while (std::getline(in, line)) {
+            size_t tab = line.find('\t');
+            if (tab != std::string::npos) {
+                onRecord(line.substr(0, tab), line.substr(tab + 1), bytes);
+            }
+            bytes += line.size() + 1;
+        }
+        return bytes;
+    }
+
+    // Reopens segments from an earlier run in id order; all of them count as closed. A ".compacting" file is the
+    // output of a compaction that never swapped in, so its inputs are still in place and it is deleted.
+    void Recover() {
+        std::vector<std::uint64_t> ids;
+        std::vector<std::filesystem::path> stale;
+        std::string prefix = name + ".";
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            std::string file = entry.path().filename().string();
+            if (file.compare(0, prefix.size(), prefix) != 0) continue;
+            if (file.size() == prefix.size() + 16 && file.compare(file.size() - 4, 4, ".log") == 0) {
+                ids.push_back(std::stoull(file.substr(prefix.size(), 12)));
+            } else if (file.size() == prefix.size() + 27 && file.compare(file.size() - 15, 15, ".log.compacting") == 0) {
+                stale.push_back(entry.path());
+            }
+        }
+        for (const std::filesystem::path& path : stale) {
+            std::filesystem::remove(path);
+        }
+        std::sort(ids.begin(), ids.end());
+        for (std::uint64_t id : ids) {
+            std::uint64_t bytes = ReadSegment(SegmentPath(id), [&](std::string key, std::string payload, std::uint64_t) {
+                index[key] = Location{id, 0, payload.size()};
+            });
+            closed.push_back(Segment{id, bytes, false});
+            nextId = id + 1;
+        }
+        // Offsets are filled in by a second pass now that the last record of each key is known.
+        for (std::uint64_t id : ids) {
+            ReadSegment(SegmentPath(id), [&](const std::string& key, const std::string& payload, std::uint64_t offset) {
+                Location& location = index[key];
+                if (location.segment == id) {
+                    location.offset = offset + key.size() + 1;
+                    location.length = payload.size();
+                }
+            });
+        }
+    }
+
+    void CompactorLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this]() { return stopping || pending; });
+            if (stopping) return;
+            pending = false;
+            lock.unlock();
+            Compact();
+            lock.lock();
+        }
+    }
+
+    std::string directory;
+    std::string name;
+    std::uint64_t segmentBytes;
+    size_t historySegments;
+
+    mutable std::mutex mutex;           // guards everything below except the compactor thread
+    std::condition_variable wake;
+    bool pending = false;
+    bool stopping = false;
+    std::deque<Segment> closed;         // oldest first
+    Segment active{0, 0, false};
+    std::uint64_t nextId = 1;
+    std::ofstream out;
+    std::unordered_map<std::string, Location> index;
+    long compactions = 0;
+
+    std::mutex compactMutex;            // one compaction at a time
+    std::thread compactor;
+};
+
+#endif
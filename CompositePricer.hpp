@@ -0,0 +1,217 @@
+// CompositePricer.hpp
+//
+// Combines prices from several venues and internal models into one composite price per product.
+//
+// @class CompositePricer
+// @description Keeps the latest mid, spread and time of every source for every product in a source x product
+//              matrix stored as separate arrays (structure of arrays). A product's row holds its sources
+//              contiguously, padded to a multiple of four, so recomputing the composite after an update is one
+//              branch-free pass over the row that the compiler can vectorize. Sources older than the maximum age
+//              get weight zero. The composite is either the weighted mean of the fresh sources or their median.
+//              Sources are registered before the first update; products are added as they appear. Updates from
+//              unregistered sources are counted and dropped, and an update that leaves a product with no fresh
+//              weighted source is stored but produces no composite.
+//
+// @methods
+// - AddSource: Registers a source with its weight (used by the weighted method).
+// - Update: Stores one source price and computes the composite for its product; false for an unknown source or
+//   when no fresh source carries weight.
+// - GetSourceQuote: Returns the latest input of one source for one product, for diagnostics.
+// - GetSourceNames: Returns the registered sources in order.
+// - GetUnknownSourceCount: Returns the number of updates dropped because their source is not registered.
+// - GetEmptyCount: Returns the number of updates that left their product without a composite.
+// - GetMethod / GetMaxAge: Return the configuration.
+
+#ifndef COMPOSITEPRICER_HPP
+#define COMPOSITEPRICER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "IClock.hpp"
+#include "Clocks.hpp"
+
+template<typename T>
+class Price;
+
+enum CompositeMethod { WEIGHTED_MEAN, MEDIAN };
+
+// The latest input of one source for one product. A time of 0 means the source has not priced the product.
+struct SourceQuote {
+    double mid = 0.0;
+    double spread = 0.0;
+    long long time = 0;
+    bool stale = true;
+};
+
+template<typename T>
+class CompositePricer {
+public:
+    // Prices without an event time are aged with the clock instead.
+    CompositePricer(CompositeMethod _method, long long _maxAgeNanos, const IClock& _clock = RealTimeClock::Instance())
+        : method(_method), maxAgeNanos(_maxAgeNanos), clock(_clock) {}
+
+    size_t AddSource(const std::string& name, double weight = 1.0) {
+        if (!mids.empty()) {
+            throw std::logic_error("Sources must be added before the first update");
+        }
+        if (sourceIndex.count(name) > 0) {
+            throw std::invalid_argument("Duplicate price source: " + name);
+        }
+        size_t index = sourceNames.size();
+        sourceIndex.emplace(name, index);
+        sourceNames.push_back(name);
+        stride = (sourceNames.size() + LANES - 1) / LANES * LANES;
+        weights.resize(stride, 0.0);
+        weights[index] = weight;
+        return index;
+    }
+
+    bool Update(const std::string& source, const Price<T>& price, Price<T>& composite) {
+        auto sourceIt = sourceIndex.find(source);
+        if (sourceIt == sourceIndex.end()) {
+            ++unknownSourceCount;
+            return false;
+        }
+        size_t row = RowFor(price.GetProduct().GetProductId());
+        size_t cell = row + sourceIt->second;
+        long long now = price.GetEventTime() != 0 ? price.GetEventTime() : clock.NowNanos();
+        mids[cell] = price.GetMid();
+        spreads[cell] = price.GetBidOfferSpread();
+        times[cell] = now;
+
+        double mid = 0.0;
+        double spread = 0.0;
+        bool priced = method == MEDIAN ? Median(row, now, mid, spread) : WeightedMean(row, now, mid, spread);
+        if (!priced) {
+            ++emptyCount;
+            return false;
+        }
+        composite = Price<T>(price.GetProduct(), mid, spread, price.GetEventTime());
+        return true;
+    }
+
+    SourceQuote GetSourceQuote(const std::string& productId, const std::string& source) const {
+        SourceQuote quote;
+        auto productIt = productRows.find(productId);
+        auto sourceIt = sourceIndex.find(source);
+        if (productIt == productRows.end() || sourceIt == sourceIndex.end()) {
+            return quote;
+        }
+        size_t cell = productIt->second + sourceIt->second;
+        quote.mid = mids[cell];
+        quote.spread = spreads[cell];
+        quote.time = times[cell];
+        quote.stale = quote.time == 0 || clock.NowNanos() - quote.time > maxAgeNanos;
+        return quote;
+    }
+
+    const std::vector<std::string>& GetSourceNames() const { return sourceNames; }
+    long GetUnknownSourceCount() const { return unknownSourceCount; }
+    long GetEmptyCount() const { return emptyCount; }
+    CompositeMethod GetMethod() const { return method; }
+    long long GetMaxAge() const { return maxAgeNanos; }
+
+private:
+    static constexpr size_t LANES = 4;
+
+    size_t RowFor(const std::string& productId) {
+        auto it = productRows.find(productId);
+        if (it != productRows.end()) {
+            return it->second;
+        }
+        if (sourceNames.empty()) {
+            throw std::logic_error("Composite pricer has no sources");
+        }
+        size_t row = mids.size();
+        mids.resize(row + stride, 0.0);
+        spreads.resize(row + stride, 0.0);
+        times.resize(row + stride, 0);
+        productRows.emplace(productId, row);
+        return row;
+    }
+
+    // A source counts when it has priced the product within the maximum age; padding lanes have weight zero.
+    // One accumulator per lane keeps the sums independent, so the row pass vectorizes without reassociating
+    // floating-point adds (given 64-bit integer compares, i.e. SSE4.2 or later on x86).
+    bool WeightedMean(size_t row, long long now, double& mid, double& spread) const {
+        const double* rowMids = mids.data() + row;
+        const double* rowSpreads = spreads.data() + row;
+        const long long* rowTimes = times.data() + row;
+        double weightSums[LANES] = {};
+        double midSums[LANES] = {};
+        double spreadSums[LANES] = {};
+        for (size_t i = 0; i < stride; i += LANES) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                long long time = rowTimes[i + lane];
+                double fresh = static_cast<double>((time != 0) & (now - time <= maxAgeNanos));
+                double weight = weights[i + lane] * fresh;
+                weightSums[lane] += weight;
+                midSums[lane] += weight * rowMids[i + lane];
+                spreadSums[lane] += weight * rowSpreads[i + lane];
+            }
+        }
+        double weightSum = 0.0;
+        double midSum = 0.0;
+        double spreadSum = 0.0;
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            weightSum += weightSums[lane];
+            midSum += midSums[lane];
+            spreadSum += spreadSums[lane];
+        }
+        if (weightSum <= 0.0) {
+            return false;
+        }
+        mid = midSum / weightSum;
+        spread = spreadSum / weightSum;
+        return true;
+    }
+
+    bool Median(size_t row, long long now, double& mid, double& spread) {
+        scratchMids.clear();
+        scratchSpreads.clear();
+        for (size_t i = 0; i < sourceNames.size(); ++i) {
+            long long time = times[row + i];
+            if (time != 0 && now - time <= maxAgeNanos) {
+                scratchMids.push_back(mids[row + i]);
+                scratchSpreads.push_back(spreads[row + i]);
+            }
+        }
+        if (scratchMids.empty()) {
+            return false;
+        }
+        mid = MedianOf(scratchMids);
+        spread = MedianOf(scratchSpreads);
+        return true;
+    }
+
+    static double MedianOf(std::vector<double>& values) {
+        size_t half = values.size() / 2;
+        std::nth_element(values.begin(), values.begin() + half, values.end());
+        double upper = values[half];
+        if (values.size() % 2 == 1) return upper;
+        double lower = *std::max_element(values.begin(), values.begin() + half);
+        return (lower + upper) / 2.0;
+    }
+
+    CompositeMethod method;
+    long long maxAgeNanos;
+    const IClock& clock;
+    std::vector<std::string> sourceNames;
+    std::unordered_map<std::string, size_t> sourceIndex;
+    std::vector<double> weights;                   // one per lane of a row, zero for padding
+    size_t stride = 0;
+    std::unordered_map<std::string, size_t> productRows;
+    std::vector<double> mids;
+    std::vector<double> spreads;
+    std::vector<long long> times;
+    std::vector<double> scratchMids;
+    std::vector<double> scratchSpreads;
+    long unknownSourceCount = 0;
+    long emptyCount = 0;
+};
+
+#endif
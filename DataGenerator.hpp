@@ -8,9 +8,13 @@
 //              Data includes realistic timestamps, random pricing, and systematic oscillations to mimic market behavior.
 //
 // @methods 
-// - GenOrderBook: Generates order book data for specified products.
-// - GenTrades: Generates trade data for specified products.
-// - GenInquiries: Generates inquiry data for specified products.
+// - GenOrderBook: Generates order book data for specified products, with a configurable number of levels.
+//                 Timestamps start at the time of the given clock, so a manual clock makes the files reproducible.
+//                 Each product's series starts at that time, and the rows of all products are merged in
+//                 timestamp order, as a live feed would deliver them.
+// - GenTrades: Generates trade data for specified products, stamped one millisecond apart from the clock's time.
+// - GenInquiries: Generates inquiry data for specified products, stamped one millisecond apart from the clock's time
+//                 and spread over four clients.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -23,17 +27,23 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <sstream>
 #include <random>
-#include <chrono>
+#include <algorithm>
 #include "TimeUtils.hpp"
+#include "Clocks.hpp"
 #include "RandomUtils.hpp"
 #include "PriceUtils.hpp"
 
 class DataGenerator {
 private:
-    static void WriteOrderBookHeader(std::ofstream& pFile, std::ofstream& oFile) {
+    static void WriteOrderBookHeader(std::ofstream& pFile, std::ofstream& oFile, int bookDepth) {
         pFile << "Timestamp,CUSIP,Bid,Ask,Spread" << std::endl;
-        oFile << "Timestamp,CUSIP,Bid1,BidSize1,Ask1,AskSize1,Bid2,BidSize2,Ask2,AskSize2,Bid3,BidSize3,Ask3,AskSize3,Bid4,BidSize4,Ask4,AskSize4,Bid5,BidSize5,Ask5,AskSize5" << std::endl;
+        oFile << "Timestamp,CUSIP";
+        for (int level = 1; level <= bookDepth; ++level) {
+            oFile << ",Bid" << level << ",BidSize" << level << ",Ask" << level << ",AskSize" << level;
+        }
+        oFile << std::endl;
     }
 
     static void OscillateValue(double& value, bool& increasing, double step, double upperBound, double lowerBound) {
@@ -46,7 +56,7 @@ private:
         }
     }
 
-    static void WriteOrderBookData(std::ofstream& pFile, std::ofstream& oFile, const std::string& timestamp, const std::string& product, double midPrice, double randomSpread, double fixSpread) {
+    static void WriteOrderBookData(std::ostream& pFile, std::ostream& oFile, const std::string& timestamp, const std::string& product, double midPrice, double randomSpread, double fixSpread, int bookDepth) {
         double randomBid = midPrice - randomSpread / 2.0;
         double randomAsk = midPrice + randomSpread / 2.0;
 
@@ -54,7 +64,7 @@ private:
               << PriceUtils::Price2Frac(randomAsk) << "," << randomSpread << std::endl;
 
         oFile << timestamp << "," << product;
-        for (int level = 1; level <= 5; ++level) {
+        for (int level = 1; level <= bookDepth; ++level) {
             double fixBid = midPrice - fixSpread * level / 2.0;
             double fixAsk = midPrice + fixSpread * level / 2.0;
             int size = level * 1'000'000;
@@ -69,44 +79,71 @@ public:
                              const std::string& priceFile,
                              const std::string& orderbookFile,
                              long long seed,
-                             int numDataPoints) {
+                             int numDataPoints,
+                             int bookDepth = 5,
+                             const IClock& clock = RealTimeClock::Instance()) {
         std::ofstream pFile(priceFile);
         std::ofstream oFile(orderbookFile);
         std::mt19937 gen(seed);
         std::uniform_int_distribution<> ms_dist(1, 20);
 
-        WriteOrderBookHeader(pFile, oFile);
+        WriteOrderBookHeader(pFile, oFile, bookDepth);
+
+        // Rows of one product are generated together and then merged with the others by time.
+        struct Row {
+            long long time;
+            std::string price;
+            std::string book;
+        };
+        std::vector<Row> rows;
+        rows.reserve(products.size() * static_cast<size_t>(std::max(numDataPoints, 0)));
+        std::ostringstream priceRow;
+        std::ostringstream bookRow;
 
         for (const auto& product : products) {
             double midPrice = 99.00;
             bool priceIncreasing = true;
             bool spreadIncreasing = true;
             double fixSpread = 1.0 / 128.0;
-            auto curTime = std::chrono::system_clock::now();
+            long long curTime = clock.NowNanos();
 
             for (int i = 0; i < numDataPoints; ++i) {
                 double randomSpread = RandomUtils::GenRandomSpread(gen);
-                curTime += std::chrono::milliseconds(ms_dist(gen));
-                std::string timestamp = TimeUtils::FormatTime(curTime);
+                curTime += ms_dist(gen) * 1000000LL;
+                std::string timestamp = TimeUtils::FormatNanos(curTime);
 
-                WriteOrderBookData(pFile, oFile, timestamp, product, midPrice, randomSpread, fixSpread);
+                priceRow.str(std::string());
+                bookRow.str(std::string());
+                WriteOrderBookData(priceRow, bookRow, timestamp, product, midPrice, randomSpread, fixSpread, bookDepth);
+                rows.push_back(Row{curTime, priceRow.str(), bookRow.str()});
 
                 OscillateValue(midPrice, priceIncreasing, 1.0 / 256.0, 101.0, 99.0);
                 OscillateValue(fixSpread, spreadIncreasing, 1.0 / 128.0, 1.0 / 32.0, 1.0 / 128.0);
             }
         }
 
+        // Timestamps are written to the millisecond, so rows are ordered on that and ties keep product order.
+        std::stable_sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            return a.time / 1000000LL < b.time / 1000000LL;
+        });
+        for (const Row& row : rows) {
+            pFile << row.price;
+            oFile << row.book;
+        }
+
         pFile.close();
         oFile.close();
     }
 
     static void GenTrades(const std::vector<std::string>& products,
                           const std::string& tradeFile,
-                          long long seed) {
+                          long long seed,
+                          const IClock& clock = RealTimeClock::Instance()) {
         std::vector<std::string> books = {"TRSY1", "TRSY2", "TRSY3"};
         std::vector<long> quantities = {1000000, 2000000, 3000000, 4000000, 5000000};
         std::ofstream tFile(tradeFile);
         std::mt19937 gen(seed);
+        long long curTime = clock.NowNanos();
 
         for (const auto& product : products) {
             for (int i = 0; i < 10; ++i) {
@@ -118,7 +155,8 @@ public:
                 std::string book = books[i % books.size()];
 
                 tFile << product << "," << tradeId << "," << PriceUtils::Price2Frac(price) << "," 
-                      << book << "," << quantity << "," << side << std::endl;
+                      << book << "," << quantity << "," << side << "," << TimeUtils::FormatNanos(curTime) << std::endl;
+                curTime += 1000000LL;
             }
         }
 
@@ -127,9 +165,11 @@ public:
 
     static void GenInquiries(const std::vector<std::string>& products,
                              const std::string& inquiryFile,
-                             long long seed) {
+                             long long seed,
+                             const IClock& clock = RealTimeClock::Instance()) {
         std::ofstream iFile(inquiryFile);
         std::mt19937 gen(seed);
+        long long curTime = clock.NowNanos();
         std::vector<long> quantities = {1000000, 2000000, 3000000, 4000000, 5000000};
 
         for (const auto& product : products) {
@@ -142,7 +182,9 @@ public:
                 std::string status = "RECEIVED";
 
                 iFile << inquiryId << "," << product << "," << side << "," 
-                      << quantity << "," << PriceUtils::Price2Frac(price) << "," << status << std::endl;
+                      << quantity << "," << PriceUtils::Price2Frac(price) << "," << status << ","
+                      << TimeUtils::FormatNanos(curTime) << ",CLIENT" << (i % 4 + 1) << std::endl;
+                curTime += 1000000LL;
             }
         }
 
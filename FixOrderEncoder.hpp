@@ -0,0 +1,242 @@
+// FixOrderEncoder.hpp
+//
+// Encodes execution orders as FIX 4.4 NewOrderSingle (35=D) messages for the venues they are routed to.
+//
+// @class FixOrderEncoder
+// @description Holds one venue's message pre-built once: the header, the static tags, and fixed-width slots for
+//              the fields that change per order (MsgSeqNum, SendingTime, Side, OrderQty, OrdType, Price,
+//              TimeInForce, TransactTime). Encoding an order writes digits into those slots in place and appends
+//              the variable-length tail (Symbol, ClOrdID) and the trailer. The checksum starts from the byte sum
+//              of the static part, computed once, and adds only the bytes written per order; the body length is
+//              the fixed body plus the tail. The date and time of day of SendingTime are re-rendered only when
+//              the second changes. Numeric slots carry leading zeros, which FIX allows for int, Qty and Price.
+//
+// @class FixOrderSender
+// @description Routes execution orders to per-venue encoders and writes each message to the venue's sink, such
+//              as a file or a local socket standing in for the venue session.
+//
+// @methods (FixOrderEncoder)
+// - Encode: Builds the message for one order at a time in nanoseconds; returns a view valid until the next call.
+// - GetSeqNum: Returns the last sequence number used.
+//
+// @methods (FixOrderSender)
+// - AddVenue: Registers a venue with its session ids and sink.
+// - Send: Encodes one order for its venue and writes it; returns false for a venue that is not registered.
+// - GetSentCount: Returns the number of messages written.
+
+#ifndef FIXORDERENCODER_HPP
+#define FIXORDERENCODER_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include "ClientSinks.hpp"
+#include "ExecutionOrder.hpp"
+#include "IClock.hpp"
+
+class FixOrderEncoder {
+public:
+    FixOrderEncoder(const std::string& senderCompId, const std::string& targetCompId) {
+        // Header up to the body length, whose value is always four digits.
+        message = "8=FIX.4.4\x01" "9=";
+        bodyLengthAt = Slot(4);
+        message += '\x01';
+        bodyStart = message.size();
+
+        message += "35=D\x01" "49=" + senderCompId + "\x01" "56=" + targetCompId + "\x01" "34=";
+        seqNumAt = Slot(SEQ_WIDTH);
+        message += "\x01" "52=";
+        sendingTimeAt = Slot(TIME_WIDTH);
+        message += "\x01" "21=1\x01" "167=TBOND\x01" "54=";
+        sideAt = Slot(1);
+        message += "\x01" "38=";
+        quantityAt = Slot(QTY_WIDTH);
+        message += "\x01" "40=";
+        ordTypeAt = Slot(1);
+        message += "\x01" "44=";
+        priceAt = Slot(PRICE_WIDTH);
+        message += "\x01" "59=";
+        timeInForceAt = Slot(1);
+        message += "\x01" "60=";
+        transactTimeAt = Slot(TIME_WIDTH);
+        message += '\x01';
+        fixedLength = message.size();
+
+        // Every byte outside the slots is constant; slots hold '0' placeholders until the first order.
+        staticSum = 0;
+        for (size_t i = 0; i < fixedLength; ++i) {
+            staticSum += static_cast<unsigned char>(message[i]);
+        }
+        for (const auto& [at, width] : { std::pair{bodyLengthAt, 4}, {seqNumAt, SEQ_WIDTH}, {sendingTimeAt, TIME_WIDTH},
+                                         {sideAt, 1}, {quantityAt, QTY_WIDTH}, {ordTypeAt, 1}, {priceAt, PRICE_WIDTH},
+                                         {timeInForceAt, 1}, {transactTimeAt, TIME_WIDTH} }) {
+            staticSum -= '0' * static_cast<unsigned>(width);
+        }
+        message.reserve(fixedLength + 128);
+    }
+
+    template<typename T>
+    std::string_view Encode(const ExecutionOrder<T>& order, long long nowNanos) {
+        unsigned sum = staticSum;
+        sum += PutDigits(seqNumAt, SEQ_WIDTH, ++seqNum);
+        sum += PutTime(nowNanos) * 2;
+        std::memcpy(&message[transactTimeAt], &message[sendingTimeAt], TIME_WIDTH);
+        sum += PutChar(sideAt, order.GetSide() == BID ? '1' : '2');
+        sum += PutDigits(quantityAt, QTY_WIDTH, static_cast<unsigned long long>(order.GetVisibleQuantity() + order.GetHiddenQuantity()));
+        sum += PutPrice(order.GetPrice());
+        sum += PutOrderType(order.GetOrderType());
+
+        message.resize(fixedLength);
+        size_t tailStart = message.size();
+        message.append("55=").append(order.GetProduct().GetProductId()).append("\x01" "11=").append(order.GetOrderId()).append("\x01");
+        for (size_t i = tailStart; i < message.size(); ++i) {
+            sum += static_cast<unsigned char>(message[i]);
+        }
+
+        if (message.size() - bodyStart > 9999) {
+            throw std::length_error("FIX message body exceeds four digits");
+        }
+        sum += PutDigits(bodyLengthAt, 4, message.size() - bodyStart);
+        char checksum[8] = {'1', '0', '=', 0, 0, 0, '\x01', 0};
+        unsigned value = sum % 256;
+        checksum[3] = static_cast<char>('0' + value / 100);
+        checksum[4] = static_cast<char>('0' + value / 10 % 10);
+        checksum[5] = static_cast<char>('0' + value % 10);
+        message.append(checksum, 7);
+        return message;
+    }
+
+    unsigned long long GetSeqNum() const { return seqNum; }
+
+private:
+    static constexpr int SEQ_WIDTH = 9;
+    static constexpr int TIME_WIDTH = 21;    // YYYYMMDD-HH:MM:SS.sss
+    static constexpr int QTY_WIDTH = 10;
+    static constexpr int PRICE_WIDTH = 12;   // PPP.dddddddd, exact for 1/256 ticks
+    static constexpr long long NANOS_PER_SECOND = 1000000000LL;
+
+    size_t Slot(int width) {
+        size_t at = message.size();
+        message.append(static_cast<size_t>(width), '0');
+        return at;
+    }
+
+    // Each Put writes a slot and returns the byte sum of what it wrote.
+    unsigned PutDigits(size_t at, int width, unsigned long long value) {
+        unsigned sum = 0;
+        for (int i = width - 1; i >= 0; --i) {
+            char digit = static_cast<char>('0' + value % 10);
+            value /= 10;
+            message[at + i] = digit;
+            sum += static_cast<unsigned char>(digit);
+        }
+        return sum;
+    }
+
+    unsigned PutChar(size_t at, char value) {
+        message[at] = value;
+        return static_cast<unsigned char>(value);
+    }
+
+    unsigned PutPrice(double price) {
+        unsigned long long scaled = static_cast<unsigned long long>(std::llround(std::fabs(price) * 1e8));
+        if (scaled >= 100000000000ULL) {
+            throw std::out_of_range("Price does not fit the FIX price slot");
+        }
+        unsigned sum = PutDigits(priceAt, 3, scaled / 100000000ULL);
+        sum += PutChar(priceAt + 3, '.');
+        sum += PutDigits(priceAt + 4, 8, scaled % 100000000ULL);
+        return sum;
+    }
+
+    unsigned PutOrderType(OrderType orderType) {
+        char ordType = '2';
+        char timeInForce = '0';
+        switch (orderType) {
+            case MARKET: ordType = '1'; break;
+            case LIMIT: ordType = '2'; break;
+            case STOP: ordType = '3'; break;
+            case IOC: timeInForce = '3'; break;
+            case FOK: timeInForce = '4'; break;
+        }
+        return PutChar(ordTypeAt, ordType) + PutChar(timeInForceAt, timeInForce);
+    }
+
+    // SendingTime in UTC; the date and time of day are rendered once per second.
+    unsigned PutTime(long long nowNanos) {
+        long long second = nowNanos / NANOS_PER_SECOND;
+        if (second != cachedSecond) {
+            std::time_t seconds = static_cast<std::time_t>(second);
+            std::tm fields{};
+            gmtime_r(&seconds, &fields);
+            char text[TIME_WIDTH + 1];
+            std::strftime(text, sizeof(text), "%Y%m%d-%H:%M:%S.", &fields);
+            message.replace(sendingTimeAt, 18, text, 18);
+            cachedSecondSum = 0;
+            for (int i = 0; i < 18; ++i) {
+                cachedSecondSum += static_cast<unsigned char>(text[i]);
+            }
+            cachedSecond = second;
+        }
+        return cachedSecondSum + PutDigits(sendingTimeAt + 18, 3, static_cast<unsigned long long>(nowNanos / 1000000 % 1000));
+    }
+
+    std::string message;
+    size_t bodyStart = 0;
+    size_t fixedLength = 0;
+    size_t bodyLengthAt = 0;
+    size_t seqNumAt = 0;
+    size_t sendingTimeAt = 0;
+    size_t sideAt = 0;
+    size_t quantityAt = 0;
+    size_t ordTypeAt = 0;
+    size_t priceAt = 0;
+    size_t timeInForceAt = 0;
+    size_t transactTimeAt = 0;
+    unsigned staticSum = 0;
+    unsigned long long seqNum = 0;
+    long long cachedSecond = -1;
+    unsigned cachedSecondSum = 0;
+};
+
+class FixOrderSender {
+public:
+    explicit FixOrderSender(const IClock& _clock) : clock(_clock) {}
+
+    void AddVenue(Market market, const std::string& senderCompId, const std::string& targetCompId, IClientSink* sink) {
+        Venue& venue = venues[market];
+        venue.encoder = std::make_unique<FixOrderEncoder>(senderCompId, targetCompId);
+        venue.sink = sink;
+    }
+
+    template<typename T>
+    bool Send(const ExecutionOrder<T>& order, Market market) {
+        Venue& venue = venues[market];
+        if (!venue.encoder) {
+            return false;
+        }
+        venue.sink->Write(venue.encoder->Encode(order, clock.NowNanos()));
+        ++sent;
+        return true;
+    }
+
+    long GetSentCount() const { return sent; }
+
+private:
+    struct Venue {
+        std::unique_ptr<FixOrderEncoder> encoder;
+        IClientSink* sink = nullptr;
+    };
+
+    const IClock& clock;
+    std::array<Venue, 3> venues;    // indexed by Market
+    long sent = 0;
+};
+
+#endif
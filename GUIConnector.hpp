@@ -8,7 +8,8 @@
 //              to a predefined file, appending each update with a timestamp for GUI consumption.
 //
 // @methods 
-// - Publish: Writes the current time and price data to a file in an append mode.
+// - Publish: Writes the time of the service's clock and the price data to the service's output file in an
+//   append mode.
 //
 // @attributes
 // - service: A pointer to the associated `GUIService` that this connector works with.
@@ -22,7 +23,7 @@
 #define GUICONNECTOR_HPP
 
 #include "soa.hpp"
-#include "TimeUtils.hpp"
+#include "IClock.hpp"
 #include <fstream>
 
 template<typename T>
@@ -35,9 +36,9 @@ public:
     GUIConnector(GUIService<T>* _service) : service(_service) {}
     void Publish(Price<T>& data) override {
         std::ofstream outFile;
-        outFile.open("../res/gui.txt", std::ios::app);
+        outFile.open(service->GetOutputFile(), std::ios::app);
         // outFile << getTime() << "," << data << std::endl;
-        outFile << TimeUtils::GetCurrentTime() << "," << data << std::endl;
+        outFile << service->GetClock().NowString() << "," << data << std::endl;
         outFile.close();
     }
 
@@ -4,13 +4,15 @@
 //
 // @class GUIService
 // @description This class handles the flow of price data to a GUI, using a connector and a throttling mechanism
-//              to regulate updates.
+//              to regulate updates. The throttle is a gate that a timer on the shared timer wheel reopens, so prices
+//              are not compared against the clock one by one.
 //
 // @methods 
 // - OnMessage: Placeholder for processing incoming price data (not implemented).
 // - GetGUIServiceListener: Retrieves the service listener for GUI-specific events.
 // - GetConnector: Retrieves the connector for publishing price data.
 // - GetThrottle: Returns the current throttling interval in milliseconds.
+// - GetClock: Returns the clock used to stamp published prices.
 // - PublishThrottledPrice: Publishes price data to the GUI if the throttling condition is met.
 //
 // @date 2024-12-20
@@ -18,7 +20,10 @@
 //
 // @attributes
 // - throttle: Time interval in milliseconds for throttling price updates.
-// - startTime: Tracks the last time a price was published.
+// - timers: Timer wheel that reopens the gate once the throttle interval has passed.
+// - clock: Clock that stamps published prices; the throttle follows the clock of the timer wheel.
+// - outputFile: File the connector appends prices to (../res/gui.txt unless given).
+// - gateOpen: Whether the next price may be published.
 //
 // @notes Throttling helps avoid excessive updates to the GUI for performance efficiency.
 //
@@ -29,6 +34,9 @@
 
 #include "BaseService.hpp"
 #include "pricingservice.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
+#include "Clocks.hpp"
 
 template<typename T>
 class GUIConnector;
@@ -39,8 +47,9 @@ template<typename T>
 class GUIService : public BaseService<std::string, Price<T>>  
 {
 public:
-    GUIService();
-    ~GUIService() = default;
+    explicit GUIService(TimerWheel& _timers, const IClock& _clock = RealTimeClock::Instance(),
+                        std::string _outputFile = "../res/gui.txt");
+    ~GUIService();
 
     void OnMessage(Price<T>& data) override {
     }
@@ -48,6 +57,8 @@ public:
     GUIServiceListener<T>* GetGUIServiceListener();
     GUIConnector<T>* GetConnector();
     int GetThrottle() const;
+    const IClock& GetClock() const;
+    const std::string& GetOutputFile() const;
 
     void PublishThrottledPrice(Price<T>& price);
 
@@ -55,19 +66,37 @@ private:
     GUIConnector<T>* connector;
     GUIServiceListener<T>* guiservicelistener;
     int throttle;
-    std::chrono::system_clock::time_point startTime;
+    TimerWheel& timers;
+    const IClock& clock;
+    std::string outputFile;
+    bool gateOpen;
+    TimerId gateTimer;
+
+    void CloseGate();
 };
 
 #include "GUIConnector.hpp"         
 #include "GUIServiceListener.hpp"  
 
 template<typename T>
-GUIService<T>::GUIService() :
+GUIService<T>::GUIService(TimerWheel& _timers, const IClock& _clock, std::string _outputFile) :
     connector(new GUIConnector<T>(this)), 
     guiservicelistener(new GUIServiceListener<T>(this)), 
     throttle(300), 
-    startTime(std::chrono::system_clock::now())
+    timers(_timers),
+    clock(_clock),
+    outputFile(std::move(_outputFile)),
+    gateOpen(false),
+    gateTimer(INVALID_TIMER)
+{
+    // As before, nothing is published until one full interval after start-up.
+    CloseGate();
+}
+
+template<typename T>
+GUIService<T>::~GUIService()
 {
+    timers.Cancel(gateTimer);
 }
 
 template<typename T>
@@ -88,15 +117,33 @@ int GUIService<T>::GetThrottle() const
     return throttle;
 }
 
+template<typename T>
+const IClock& GUIService<T>::GetClock() const
+{
+    return clock;
+}
+
+template<typename T>
+const std::string& GUIService<T>::GetOutputFile() const
+{
+    return outputFile;
+}
+
 template<typename T>
 void GUIService<T>::PublishThrottledPrice(Price<T>& price)
 {
-    auto now = std::chrono::system_clock::now();
-    auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(now - startTime);
-    if (diff.count() > throttle) {
-        startTime = now;
+    TRACE_SPAN("GUIService::PublishThrottledPrice");
+    if (gateOpen) {
+        CloseGate();
         connector->Publish(price);
     }
 }
 
+template<typename T>
+void GUIService<T>::CloseGate()
+{
+    gateOpen = false;
+    gateTimer = timers.ScheduleAfter(throttle * 1000000LL, [this]() { gateOpen = true; });
+}
+
 #endif
@@ -7,7 +7,8 @@
 //              using market data such as order books.
 //
 // @methods 
-// - AlgoExecuteOrder: Executes an algorithmic order based on the provided order book.
+// - AlgoExecuteOrder: Executes an algorithmic order based on the provided order book, or on the top of the
+//                     book of a product kept from deltas.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -19,13 +20,14 @@
 
 #include "soa.hpp"
 #include "IAlgoExecution.hpp"
-#include "marketdataservice.hpp" // for OrderBook<T>
+#include "marketdataservice.hpp" // for OrderBook<T, Depth>
 
-template<typename T>
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
 class IAlgoExecutionService : public Service<std::string, IAlgoExecution<T>> {
 public:
     virtual ~IAlgoExecutionService() = default;
-    virtual void AlgoExecuteOrder(OrderBook<T>& orderBook) = 0;
+    virtual void AlgoExecuteOrder(OrderBook<T, Depth>& orderBook) = 0;
+    virtual void AlgoExecuteOrder(const T& product, const BidOffer& top, long long eventTime) = 0;
 };
 
 #endif
@@ -18,10 +18,10 @@
 #define IALGOEXECUTIONSERVICELISTENER_HPP
 
 #include "soa.hpp"
-#include "marketdataservice.hpp" // for OrderBook<T>
+#include "marketdataservice.hpp" // for OrderBook<T, Depth>
 
-template<typename T>
-class IAlgoExecutionServiceListener : public ServiceListener<OrderBook<T>> {
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class IAlgoExecutionServiceListener : public ServiceListener<OrderBook<T, Depth>> {
 public:
     virtual ~IAlgoExecutionServiceListener() = default;
 };
@@ -6,9 +6,13 @@
 // @description This interface provides a method for creating execution orders based on market data
 //              such as order books and a unique count identifier.
 //
+//              Depth is the order book depth of the market data feed driving the factory.
+//
 // @methods 
-// - CreateExecutionOrder: Creates and returns a unique pointer to an `ExecutionOrder` based on the provided
-//                         order book and count.
+// - CreateExecutionOrder: Creates and returns a unique pointer to an `ExecutionOrder` based on the top of the
+//                         book, or on a full order book, and a count. The order book overload uses its best
+//                         bid and offer unless a factory needs the deeper levels.
+// - GetStrategyName: Returns the name used to attribute this factory's orders in execution analytics.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -18,13 +22,20 @@
 #ifndef ALGOORDERFACTORY_HPP
 #define ALGOORDERFACTORY_HPP
 
+#include <memory>
+#include <string>
 #include "ExecutionOrder.hpp"
+#include "marketdataservice.hpp" // for OrderBook<T, Depth>
 
-template<typename T>
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
 class IAlgoOrderFactory {
 public:
     virtual ~IAlgoOrderFactory() = default;
-    virtual std::unique_ptr<ExecutionOrder<T>> CreateExecutionOrder(const OrderBook<T>& orderBook, long count) = 0;
+    virtual std::unique_ptr<ExecutionOrder<T>> CreateExecutionOrder(const T& product, const BidOffer& top, long count) = 0;
+    virtual std::unique_ptr<ExecutionOrder<T>> CreateExecutionOrder(const OrderBook<T, Depth>& orderBook, long count) {
+        return CreateExecutionOrder(orderBook.GetProduct(), orderBook.BestBidOffer(), count);
+    }
+    virtual std::string GetStrategyName() const = 0;
 };
 
 #endif
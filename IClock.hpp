@@ -0,0 +1,30 @@
+// IClock.hpp
+//
+// Defines the clock interface that services and connectors read time from.
+//
+// @class IClock
+// @description Supplies the current time in nanoseconds since the epoch. Services take a clock instead of calling
+//              std::chrono directly, so a replay driven by an event-time or manual clock throttles, times out and
+//              stamps records exactly as the live run did, however fast it is played.
+//
+// @methods
+// - NowNanos: Returns the current time in nanoseconds since the epoch.
+// - NowString: Returns the current time formatted like TimeUtils::GetCurrentTime.
+
+#ifndef ICLOCK_HPP
+#define ICLOCK_HPP
+
+#include <string>
+#include "TimeUtils.hpp"
+
+class IClock {
+public:
+    virtual ~IClock() = default;
+    virtual long long NowNanos() const = 0;
+
+    std::string NowString() const {
+        return TimeUtils::FormatNanos(NowNanos());
+    }
+};
+
+#endif
@@ -0,0 +1,156 @@
+// InquiryQuoter.hpp
+//
+// Prices client inquiries from the market and caches the quotes between price ticks.
+//
+// @class InquiryQuoter
+// @description Listens to PricingService and quotes an inquiry from the latest mid and spread of its product. A
+//              client buy is quoted at the offer and a client sell at the bid. Each size bucket widens the quote by
+//              a fixed amount, and the result is rounded away from mid to a 1/256 tick. Quotes are cached per
+//              product, side and size bucket in one flat array. Every entry carries the product's price version,
+//              and a price tick only increments that version, so invalidation is O(1) however many entries the
+//              product has. An entry whose version is behind is recomputed on its next use. A burst of inquiries
+//              in one CUSIP between ticks then costs one product lookup and one array read per inquiry.
+//
+// @class InquiryQuoterListener
+// @description Forwards prices from PricingService to the quoter.
+//
+// @methods (InquiryQuoter)
+// - OnPrice: Records the latest price of a product and invalidates its cached quotes.
+// - Quote: Returns the quote for a product, side and quantity; false if the product has no price yet.
+// - GetSizeBucket: Returns the bucket of a quantity.
+// - GetPriceListener: Listener to register on the pricing service.
+// - GetHitCount / GetMissCount: Cache statistics.
+//
+// @functions
+// - InquirySizeBucket: Returns the bucket of a quantity under the default size limits, which RfqAnalytics shares.
+
+#ifndef INQUIRYQUOTER_HPP
+#define INQUIRYQUOTER_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "soa.hpp"
+#include "pricingservice.hpp"
+#include "tradebookingservice.hpp"
+
+// Inquiry size buckets: up to 1MM, 2MM, 5MM, 10MM, and above.
+inline constexpr std::array<long, 4> INQUIRY_SIZE_LIMITS = { 1000000, 2000000, 5000000, 10000000 };
+
+inline size_t InquirySizeBucket(long quantity) {
+    return static_cast<size_t>(std::lower_bound(INQUIRY_SIZE_LIMITS.begin(), INQUIRY_SIZE_LIMITS.end(), quantity)
+                               - INQUIRY_SIZE_LIMITS.begin());
+}
+
+template<typename T>
+class InquiryQuoterListener;
+
+template<typename T>
+class InquiryQuoter {
+public:
+    // Quantities up to sizeLimits[i] fall in bucket i; larger ones fall in the last bucket.
+    explicit InquiryQuoter(std::vector<long> _sizeLimits = std::vector<long>(INQUIRY_SIZE_LIMITS.begin(), INQUIRY_SIZE_LIMITS.end()),
+                           double _widenPerBucket = 1.0 / 256.0)
+        : sizeLimits(std::move(_sizeLimits)), widenPerBucket(_widenPerBucket),
+          bucketCount(sizeLimits.size() + 1), listener(std::make_unique<InquiryQuoterListener<T>>(this)) {
+        if (!std::is_sorted(sizeLimits.begin(), sizeLimits.end())) {
+            throw std::invalid_argument("Inquiry size buckets must be in ascending order");
+        }
+    }
+
+    void OnPrice(const Price<T>& price) {
+        ProductState& product = products[ProductIndex(price.GetProduct().GetProductId())];
+        product.mid = price.GetMid();
+        product.halfSpread = price.GetBidOfferSpread() / 2.0;
+        ++product.version;
+    }
+
+    bool Quote(const T& product, Side side, long quantity, double& quote) {
+        auto it = productIndex.find(product.GetProductId());
+        if (it == productIndex.end()) {
+            return false;
+        }
+        const ProductState& state = products[it->second];
+        size_t bucket = GetSizeBucket(quantity);
+        QuoteEntry& entry = quotes[(it->second * 2 + (side == BUY ? 0 : 1)) * bucketCount + bucket];
+        if (entry.version == state.version) {
+            ++hits;
+            quote = entry.price;
+            return true;
+        }
+
+        ++misses;
+        double width = state.halfSpread + widenPerBucket * static_cast<double>(bucket);
+        entry.price = side == BUY ? std::ceil((state.mid + width) * TICKS) / TICKS
+                                  : std::floor((state.mid - width) * TICKS) / TICKS;
+        entry.version = state.version;
+        quote = entry.price;
+        return true;
+    }
+
+    size_t GetSizeBucket(long quantity) const {
+        return static_cast<size_t>(std::lower_bound(sizeLimits.begin(), sizeLimits.end(), quantity) - sizeLimits.begin());
+    }
+
+    InquiryQuoterListener<T>* GetPriceListener() { return listener.get(); }
+    long GetHitCount() const { return hits; }
+    long GetMissCount() const { return misses; }
+
+private:
+    static constexpr double TICKS = 256.0;
+
+    // Versions start at 1 once a product is priced; cache entries start at 0, so they miss until first computed.
+    struct ProductState {
+        double mid = 0.0;
+        double halfSpread = 0.0;
+        std::uint64_t version = 0;
+    };
+
+    struct QuoteEntry {
+        std::uint64_t version = 0;
+        double price = 0.0;
+    };
+
+    size_t ProductIndex(const std::string& productId) {
+        auto it = productIndex.find(productId);
+        if (it != productIndex.end()) {
+            return it->second;
+        }
+        size_t index = products.size();
+        productIndex.emplace(productId, index);
+        products.emplace_back();
+        quotes.resize(quotes.size() + 2 * bucketCount);
+        return index;
+    }
+
+    std::vector<long> sizeLimits;
+    double widenPerBucket;
+    size_t bucketCount;
+    std::unordered_map<std::string, size_t> productIndex;
+    std::vector<ProductState> products;
+    std::vector<QuoteEntry> quotes;     // [product][side][size bucket]
+    std::unique_ptr<InquiryQuoterListener<T>> listener;
+    long hits = 0;
+    long misses = 0;
+};
+
+template<typename T>
+class InquiryQuoterListener : public ServiceListener<Price<T>> {
+public:
+    explicit InquiryQuoterListener(InquiryQuoter<T>* _quoter) : quoter(_quoter) {}
+
+    void ProcessAdd(Price<T>& data) override { quoter->OnPrice(data); }
+    void ProcessRemove(Price<T>& data) override {}
+    void ProcessUpdate(Price<T>& data) override { quoter->OnPrice(data); }
+
+private:
+    InquiryQuoter<T>* quoter;
+};
+
+#endif
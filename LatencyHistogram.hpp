@@ -0,0 +1,107 @@
+// LatencyHistogram.hpp
+//
+// Provides a fixed-size, log-linear histogram for recording latencies in nanoseconds.
+//
+// @class LatencyHistogram
+// @description Buckets values by power of two with 16 linear sub-buckets per power (about 6% relative precision),
+//              so recording is O(1) with no allocation and percentiles can be read at any time. Histograms with
+//              the same layout can be merged, which makes results comparable across runs and builds.
+//
+// @methods
+// - Record: Adds one observation in nanoseconds.
+// - Percentile: Returns the upper bound of the bucket holding the given percentile (0-100).
+// - Mean: Returns the arithmetic mean of all observations.
+// - Max: Returns the largest recorded observation.
+// - Count: Returns the number of observations.
+// - Merge: Adds the counts of another histogram into this one.
+// - Reset: Clears all observations.
+
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <array>
+#include <cstdint>
+#include <algorithm>
+
+class LatencyHistogram {
+public:
+    LatencyHistogram() { Reset(); }
+
+    void Record(long long nanos) {
+        uint64_t value = nanos < 0 ? 0 : static_cast<uint64_t>(nanos);
+        ++counts[BucketIndex(value)];
+        ++count;
+        sum += static_cast<double>(value);
+        maxValue = std::max(maxValue, value);
+    }
+
+    long long Percentile(double percentile) const {
+        if (count == 0) return 0;
+        uint64_t threshold = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+        threshold = std::max<uint64_t>(threshold, 1);
+
+        uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts[i];
+            if (seen >= threshold) {
+                return static_cast<long long>(std::min(BucketUpperBound(i), maxValue));
+            }
+        }
+        return static_cast<long long>(maxValue);
+    }
+
+    double Mean() const { return count == 0 ? 0.0 : sum / count; }
+    long long Max() const { return static_cast<long long>(maxValue); }
+    long long Count() const { return static_cast<long long>(count); }
+
+    void Merge(const LatencyHistogram& other) {
+        for (int i = 0; i < BUCKET_COUNT; ++i) {
+            counts[i] += other.counts[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    void Reset() {
+        counts.fill(0);
+        count = 0;
+        sum = 0.0;
+        maxValue = 0;
+    }
+
+private:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static int HighestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1) ++bit;
+        return bit;
+#endif
+    }
+
+    static int BucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<int>(value);
+        int shift = HighestBit(value) - SUB_BUCKET_BITS;
+        return ((shift + 1) << SUB_BUCKET_BITS) + static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t BucketUpperBound(int index) {
+        if (index < SUB_BUCKETS) return static_cast<uint64_t>(index);
+        int shift = (index >> SUB_BUCKET_BITS) - 1;
+        uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + (index & (SUB_BUCKETS - 1))) << shift;
+        return lower + (uint64_t(1) << shift) - 1;
+    }
+
+    std::array<uint64_t, BUCKET_COUNT> counts;
+    uint64_t count;
+    double sum;
+    uint64_t maxValue;
+};
+
+#endif
@@ -0,0 +1,343 @@
+// LoadGenerator.hpp
+//
+// Drives a fully wired service graph in-process with synthetic prices, order books, trades, and inquiries
+// at ramping rates to find the point where the pipeline saturates.
+//
+// @class LoadGenerator
+// @description Pre-builds a pool of messages for the configured product universe, then replays them into the
+//              entry points of the graph on an open-loop schedule. Latency is measured from each message's
+//              scheduled send time to the return of the synchronous pipeline call, so queueing delay caused by
+//              a slow stage is included. Each step multiplies the offered rate until p99 latency exceeds the
+//              target or the achieved rate falls behind the offered rate. Latency is broken down by entry
+//              pipeline (price, book, trade, inquiry) and by service stage, from the spans each stage opens.
+//
+// @methods
+// - Run: Executes all ramp steps and returns one result per step.
+// - SaturationStep: Returns the index of the last step that met both the latency and throughput targets.
+// - WriteReport: Writes the throughput versus latency curve with the per-pipeline breakdown as CSV, and the
+//   per-stage latencies of each step to a second CSV next to it ("<report>_stages.csv").
+// - RunBurst: Sends a fixed number of messages back to back and returns each message's latency.
+//
+// @structs
+// - LoadMix: Relative weights of the four message types.
+// - LoadTestConfig: Ramp, pacing, and saturation settings.
+// - LoadTarget: Callables that push one message into each entry service.
+// - LoadStepResult: Throughput, latency histograms per pipeline and per stage, and per-pipeline busy time for
+//   one step.
+//
+// @notes The message pool and the stage sequence are generated from a fixed seed, and the report header records
+//        the compiler and optimisation level, so curves from different builds can be compared directly.
+
+#ifndef LOADGENERATOR_HPP
+#define LOADGENERATOR_HPP
+
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LatencyHistogram.hpp"
+#include "TraceRecorder.hpp"
+#include "ProductFactory.hpp"
+#include "pricingservice.hpp"
+#include "marketdataservice.hpp"
+#include "tradebookingservice.hpp"
+#include "inquiryservice.hpp"
+
+// Entry stages of the pipeline that the load generator can drive.
+enum LoadStage { PRICE_LOAD, MARKET_DATA_LOAD, TRADE_LOAD, INQUIRY_LOAD, LOAD_STAGE_COUNT };
+
+struct LoadMix {
+    double prices = 0.4;
+    double orderBooks = 0.3;
+    double trades = 0.2;
+    double inquiries = 0.1;
+};
+
+struct LoadTestConfig {
+    LoadMix mix;
+    double startRate = 2000.0;              // offered messages per second on the first step
+    double rampFactor = 2.0;                // rate multiplier between steps
+    int maxSteps = 10;
+    double stepSeconds = 1.0;
+    long long p99TargetNanos = 1'000'000;   // saturation threshold on end-to-end p99
+    double minDeliveryRatio = 0.95;         // achieved / offered below this counts as saturated
+    unsigned seed = 42;
+    int poolSize = 4096;
+    bool quietConsole = true;               // discard connector console output while a step runs
+};
+
+template<typename T>
+struct LoadTarget {
+    std::function<void(Price<T>&)> onPrice;
+    std::function<void(OrderBook<T>&)> onOrderBook;
+    std::function<void(Trade<T>&)> onTrade;
+    std::function<void(Inquiry<T>&)> onInquiry;
+};
+
+struct LoadStepResult {
+    double offeredRate = 0.0;
+    double achievedRate = 0.0;
+    long long messages = 0;
+    LatencyHistogram total;
+    std::array<LatencyHistogram, LOAD_STAGE_COUNT> stages;
+    std::array<double, LOAD_STAGE_COUNT> busyNanos{};
+    StageTimings serviceStages;             // per service stage, keyed by span name
+    bool saturated = false;
+};
+
+template<typename T>
+class LoadGenerator {
+public:
+    LoadGenerator(const std::vector<std::string>& productIds, LoadTarget<T> target, LoadTestConfig config = LoadTestConfig())
+        : target(std::move(target)), config(config), sequence(0)
+    {
+        BuildPools(productIds);
+    }
+
+    std::vector<LoadStepResult> Run() {
+        std::vector<LoadStepResult> results;
+        double rate = config.startRate;
+        for (int step = 0; step < config.maxSteps; ++step) {
+            results.push_back(RunStep(rate));
+            if (results.back().saturated) break;
+            rate *= config.rampFactor;
+        }
+        return results;
+    }
+
+    std::vector<long long> RunBurst(long count) {
+        std::vector<long long> latencies;
+        latencies.reserve(count);
+
+        std::streambuf* consoleBuffer = nullptr;
+        if (config.quietConsole) consoleBuffer = std::cout.rdbuf(nullptr);
+
+        for (long i = 0; i < count; ++i, ++sequence) {
+            LoadStage stage = stageSequence[sequence % stageSequence.size()];
+            auto begin = SteadyClock::now();
+            Dispatch(stage, sequence);
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - begin).count());
+        }
+
+        if (config.quietConsole) {
+            std::cout.rdbuf(consoleBuffer);
+            std::cout.clear();
+        }
+        return latencies;
+    }
+
+    static int SaturationStep(const std::vector<LoadStepResult>& results) {
+        int knee = -1;
+        for (int i = 0; i < static_cast<int>(results.size()); ++i) {
+            if (results[i].saturated) break;
+            knee = i;
+        }
+        return knee;
+    }
+
+    static void WriteReport(const std::vector<LoadStepResult>& results, const LoadTestConfig& config, const std::string& fileName) {
+        std::ofstream out(fileName);
+        out << "# build," << BuildTag() << ",seed=" << config.seed
+            << ",mix=" << config.mix.prices << "/" << config.mix.orderBooks << "/" << config.mix.trades << "/" << config.mix.inquiries
+            << ",p99_target_us=" << config.p99TargetNanos / 1000.0 << std::endl;
+        out << "step,offered_rate,achieved_rate,messages,p50_us,p99_us,p999_us,max_us,"
+            << "price_p99_us,book_p99_us,trade_p99_us,inquiry_p99_us,"
+            << "price_busy_pct,book_busy_pct,trade_busy_pct,inquiry_busy_pct,saturated" << std::endl;
+
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& r = results[i];
+            double busy = 0.0;
+            for (double b : r.busyNanos) busy += b;
+
+            out << i << "," << r.offeredRate << "," << r.achievedRate << "," << r.messages << ","
+                << r.total.Percentile(50) / 1000.0 << "," << r.total.Percentile(99) / 1000.0 << ","
+                << r.total.Percentile(99.9) / 1000.0 << "," << r.total.Max() / 1000.0;
+            for (const auto& stage : r.stages) {
+                out << "," << stage.Percentile(99) / 1000.0;
+            }
+            for (double b : r.busyNanos) {
+                out << "," << (busy > 0.0 ? 100.0 * b / busy : 0.0);
+            }
+            out << "," << (r.saturated ? "yes" : "no") << std::endl;
+        }
+
+        std::ofstream stagesOut(StagesFileName(fileName));
+        stagesOut << "step,stage,count,mean_us,p50_us,p99_us,max_us" << std::endl;
+        for (size_t i = 0; i < results.size(); ++i) {
+            for (const auto& [name, histogram] : results[i].serviceStages.GetHistograms()) {
+                stagesOut << i << "," << name << "," << histogram.Count() << "," << histogram.Mean() / 1000.0 << ","
+                          << histogram.Percentile(50) / 1000.0 << "," << histogram.Percentile(99) / 1000.0 << ","
+                          << histogram.Max() / 1000.0 << std::endl;
+            }
+        }
+    }
+
+    static std::string StagesFileName(const std::string& fileName) {
+        size_t dot = fileName.rfind('.');
+        size_t slash = fileName.rfind('/');
+        if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+            return fileName + "_stages";
+        }
+        return fileName.substr(0, dot) + "_stages" + fileName.substr(dot);
+    }
+
+private:
+    using SteadyClock = std::chrono::steady_clock;
+
+    static std::string BuildTag() {
+#if defined(__VERSION__)
+        std::string compiler = __VERSION__;
+#else
+        std::string compiler = "unknown";
+#endif
+#if defined(__OPTIMIZE__) || defined(NDEBUG)
+        return compiler + ",optimized";
+#else
+        return compiler + ",debug";
+#endif
+    }
+
+    void BuildPools(const std::vector<std::string>& productIds) {
+        std::mt19937 gen(config.seed);
+        std::uniform_int_distribution<int> tickDist(-2, 2);
+        std::uniform_int_distribution<int> sideDist(0, 1);
+        std::vector<long> quantities = {1000000, 2000000, 3000000, 4000000, 5000000};
+
+        std::vector<T> products;
+        for (const auto& id : productIds) {
+            products.push_back(ProductFactory<T>::QueryProduct(id));
+        }
+
+        std::vector<double> mids(products.size(), 99.0);
+        for (int i = 0; i < config.poolSize; ++i) {
+            size_t p = i % products.size();
+            const T& product = products[p];
+            mids[p] += tickDist(gen) / 256.0;
+            double mid = mids[p];
+            double spread = (1 + (i % 2)) / 128.0;
+
+            prices.emplace_back(product, mid, spread);
+
+            typename OrderBook<T>::Stack bids, offers;
+            for (size_t level = 1; level <= bids.size(); ++level) {
+                bids[level - 1] = Order(mid - spread * level / 2.0, level * 1000000L, BID);
+                offers[level - 1] = Order(mid + spread * level / 2.0, level * 1000000L, OFFER);
+            }
+            orderBooks.emplace_back(product, bids, offers);
+
+            Side side = sideDist(gen) == 0 ? BUY : SELL;
+            long quantity = quantities[i % quantities.size()];
+            trades.emplace_back(product, "", mid, "TRSY" + std::to_string(i % 3 + 1), quantity, side);
+            inquiries.emplace_back("", product, side, quantity, mid, RECEIVED);
+        }
+
+        std::discrete_distribution<int> stageDist({config.mix.prices, config.mix.orderBooks, config.mix.trades, config.mix.inquiries});
+        for (int i = 0; i < config.poolSize; ++i) {
+            stageSequence.push_back(static_cast<LoadStage>(stageDist(gen)));
+        }
+    }
+
+    void Dispatch(LoadStage stage, long index) {
+        size_t slot = index % config.poolSize;
+        switch (stage) {
+        case PRICE_LOAD: {
+            Price<T> price = prices[slot];
+            target.onPrice(price);
+            break;
+        }
+        case MARKET_DATA_LOAD: {
+            OrderBook<T> orderBook = orderBooks[slot];
+            target.onOrderBook(orderBook);
+            break;
+        }
+        case TRADE_LOAD: {
+            const Trade<T>& tmpl = trades[slot];
+            Trade<T> trade(tmpl.GetProduct(), "LT" + std::to_string(sequence), tmpl.GetPrice(), tmpl.GetBook(), tmpl.GetQuantity(), tmpl.GetSide());
+            target.onTrade(trade);
+            break;
+        }
+        case INQUIRY_LOAD: {
+            const Inquiry<T>& tmpl = inquiries[slot];
+            Inquiry<T> inquiry("LI" + std::to_string(sequence), tmpl.GetProduct(), tmpl.GetSide(), tmpl.GetQuantity(), tmpl.GetPrice(), RECEIVED);
+            target.onInquiry(inquiry);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    static void WaitUntil(SteadyClock::time_point when) {
+        auto now = SteadyClock::now();
+        while (now < when) {
+            // Sleep only when far ahead and spin the last millisecond, so scheduler wake-up jitter
+            // does not show up as pipeline latency.
+            if (when - now > std::chrono::milliseconds(2)) {
+                std::this_thread::sleep_for(when - now - std::chrono::milliseconds(1));
+            }
+            now = SteadyClock::now();
+        }
+    }
+
+    LoadStepResult RunStep(double rate) {
+        LoadStepResult result;
+        result.offeredRate = rate;
+
+        long long total = static_cast<long long>(rate * config.stepSeconds);
+        auto interval = std::chrono::duration<double, std::nano>(1e9 / rate);
+        // A saturated pipeline falls behind its schedule; cap the step so it cannot run forever.
+        auto deadline = std::chrono::duration<double>(config.stepSeconds * 3.0);
+
+        std::streambuf* consoleBuffer = nullptr;
+        if (config.quietConsole) consoleBuffer = std::cout.rdbuf(nullptr);
+
+        TraceRecorder::CollectStages(&result.serviceStages);
+        auto start = SteadyClock::now();
+        auto last = start;
+        for (long long i = 0; i < total; ++i, ++sequence) {
+            auto scheduled = start + std::chrono::duration_cast<SteadyClock::duration>(interval * i);
+            WaitUntil(scheduled);
+
+            LoadStage stage = stageSequence[sequence % stageSequence.size()];
+            auto begin = SteadyClock::now();
+            if (begin - start > deadline) break;
+            Dispatch(stage, sequence);
+            last = SteadyClock::now();
+
+            long long latency = std::chrono::duration_cast<std::chrono::nanoseconds>(last - scheduled).count();
+            result.total.Record(latency);
+            result.stages[stage].Record(latency);
+            result.busyNanos[stage] += std::chrono::duration<double, std::nano>(last - begin).count();
+            ++result.messages;
+        }
+        TraceRecorder::CollectStages(nullptr);
+
+        if (config.quietConsole) {
+            std::cout.rdbuf(consoleBuffer);
+            std::cout.clear();
+        }
+
+        double elapsed = std::chrono::duration<double>(last - start).count();
+        result.achievedRate = elapsed > 0.0 ? result.messages / elapsed : 0.0;
+        result.saturated = result.total.Percentile(99) > config.p99TargetNanos
+                        || result.achievedRate < config.minDeliveryRatio * rate;
+        return result;
+    }
+
+    LoadTarget<T> target;
+    LoadTestConfig config;
+    long sequence;
+
+    std::vector<Price<T>> prices;
+    std::vector<OrderBook<T>> orderBooks;
+    std::vector<Trade<T>> trades;
+    std::vector<Inquiry<T>> inquiries;
+    std::vector<LoadStage> stageSequence;
+};
+
+#endif
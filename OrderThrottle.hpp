@@ -0,0 +1,272 @@
+// OrderThrottle.hpp
+//
+// Limits the rate of orders sent to each venue and in each product, so bursts of book updates cannot push the
+// execution path past venue message limits.
+//
+// @class TokenBucket
+// @description A token bucket kept as one atomic word, the theoretical arrival time of the next order (the generic
+//              cell rate algorithm). Refill is implicit in the clock, so there is no refill thread or timer, and
+//              an order under the limit costs one load and one compare-and-swap. A rate of zero disables the bucket.
+//
+// @class OrderThrottle
+// @description Checks every order against its venue's bucket and its product's bucket. Orders over the limit are
+//              handled by the policy:
+//              - QUEUE_EXCESS keeps them in arrival order per venue and product and sends them as tokens come back.
+//              - CONFLATE_EXCESS keeps only the latest order per venue and product; older pending orders for the
+//                same product are dropped.
+//              - REJECT_EXCESS drops them.
+//              A new order waits behind the pending orders of its own product at the venue. Pending orders are
+//              released by Drain, which the owner calls on a timer and which also runs on every new order. Drain
+//              takes one order per product in turn, so a product held back by its own limit does not block the
+//              other products at the venue, and the venue's tokens are shared fairly among them.
+//
+// @methods (TokenBucket)
+// - TryAcquire: Takes one token at a time in nanoseconds; false if the bucket is empty.
+// - Refund: Returns a token taken by TryAcquire.
+//
+// @methods (OrderThrottle)
+// - SetVenueLimit: Sets the rate (orders per second) and burst of one venue.
+// - SetProductLimit: Sets the rate and burst applied to each product separately.
+// - Submit: Sends an order through the callback if it is within both limits, otherwise applies the policy.
+// - Drain: Sends pending orders that are now within the limits.
+// - DiscardPending: Drops every pending order without sending it and returns how many there were.
+// - SetDropHandler: Sets a callback run for every order dropped without being sent (rejected, conflated away or
+//                   discarded).
+// - GetPendingCount / GetRejectedCount / GetConflatedCount / GetThrottledCount: Counters.
+
+#ifndef ORDERTHROTTLE_HPP
+#define ORDERTHROTTLE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ExecutionOrder.hpp"
+#include "IClock.hpp"
+
+enum ThrottlePolicy { QUEUE_EXCESS, CONFLATE_EXCESS, REJECT_EXCESS };
+
+class TokenBucket {
+public:
+    TokenBucket() = default;
+    TokenBucket(double ratePerSecond, long burst) { Configure(ratePerSecond, burst); }
+
+    void Configure(double ratePerSecond, long burst) {
+        if (ratePerSecond < 0.0 || burst < 1) {
+            throw std::invalid_argument("Token bucket needs a non-negative rate and a burst of at least one");
+        }
+        interval = ratePerSecond > 0.0 ? static_cast<long long>(1e9 / ratePerSecond) : 0;
+        tolerance = interval * (burst - 1);
+        arrival.store(0, std::memory_order_relaxed);
+    }
+
+    bool TryAcquire(long long now) {
+        if (interval == 0) return true;
+        long long current = arrival.load(std::memory_order_relaxed);
+        for (;;) {
+            long long start = std::max(current, now);
+            if (start - now > tolerance) {
+                return false;
+            }
+            if (arrival.compare_exchange_weak(current, start + interval, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    void Refund() {
+        if (interval != 0) arrival.fetch_sub(interval, std::memory_order_relaxed);
+    }
+
+private:
+    long long interval = 0;     // nanoseconds per token
+    long long tolerance = 0;    // how far ahead of now the bucket may run, i.e. burst - 1 tokens
+    std::atomic<long long> arrival{0};
+};
+
+template<typename T>
+class OrderThrottle {
+public:
+    OrderThrottle(ThrottlePolicy _policy, const IClock& _clock) : policy(_policy), clock(_clock) {}
+
+    void SetVenueLimit(Market market, double ratePerSecond, long burst) {
+        venues[market].bucket.Configure(ratePerSecond, burst);
+    }
+
+    void SetProductLimit(double ratePerSecond, long burst) {
+        productRate = ratePerSecond;
+        productBurst = burst;
+        productBuckets.clear();
+    }
+
+    template<typename Send>
+    void Submit(const ExecutionOrder<T>& order, Market market, Send send) {
+        long long now = clock.NowNanos();
+        Venue& venue = venues[market];
+        const std::string& productId = order.GetProduct().GetProductId();
+        if (venue.pendingCount > 0) {
+            Drain(venue, market, now, send);
+        }
+        const std::deque<ExecutionOrder<T>>* waiting = venue.pendingCount > 0 ? FindQueue(venue, productId) : nullptr;
+        if ((waiting == nullptr || waiting->empty()) && TryAcquire(venue, order, now) == ACQUIRED) {
+            send(order, market);
+            return;
+        }
+        ++throttled;
+
+        switch (policy) {
+            case QUEUE_EXCESS:
+                QueueFor(venue, productId).push_back(order);
+                ++venue.pendingCount;
+                break;
+            case CONFLATE_EXCESS: {
+                std::deque<ExecutionOrder<T>>& queue = QueueFor(venue, productId);
+                if (!queue.empty()) {
+                    Drop(queue.back());
+                    queue.back() = order;
+                    ++conflated;
+                } else {
+                    queue.push_back(order);
+                    ++venue.pendingCount;
+                }
+                break;
+            }
+            case REJECT_EXCESS:
+                Drop(order);
+                ++rejected;
+                break;
+        }
+    }
+
+    template<typename Send>
+    void Drain(Send send) {
+        long long now = clock.NowNanos();
+        for (size_t market = 0; market < venues.size(); ++market) {
+            Drain(venues[market], static_cast<Market>(market), now, send);
+        }
+    }
+
+    size_t DiscardPending() {
+        size_t count = GetPendingCount();
+        for (Venue& venue : venues) {
+            for (auto& queue : venue.queues) {
+                for (const ExecutionOrder<T>& order : queue) Drop(order);
+                queue.clear();
+            }
+            venue.pendingCount = 0;
+        }
+        return count;
+    }
+
+    size_t GetPendingCount() const {
+        size_t count = 0;
+        for (const Venue& venue : venues) count += venue.pendingCount;
+        return count;
+    }
+    void SetDropHandler(std::function<void(const ExecutionOrder<T>&)> handler) { dropHandler = std::move(handler); }
+
+    long GetRejectedCount() const { return rejected; }
+    long GetConflatedCount() const { return conflated; }
+    long GetThrottledCount() const { return throttled; }
+
+private:
+    enum Acquisition { ACQUIRED, PRODUCT_LIMITED, VENUE_LIMITED };
+
+    struct Venue {
+        TokenBucket bucket;
+        // One queue per product that has been throttled at this venue, holding at most one order when conflating.
+        std::vector<std::deque<ExecutionOrder<T>>> queues;
+        std::unordered_map<std::string, size_t> queueIndex;
+        size_t pendingCount = 0;
+        size_t cursor = 0;          // the queue Drain serves first
+    };
+
+    // Takes a token from both buckets, or from neither.
+    Acquisition TryAcquire(Venue& venue, const ExecutionOrder<T>& order, long long now) {
+        TokenBucket* product = ProductBucket(order.GetProduct().GetProductId());
+        if (product != nullptr && !product->TryAcquire(now)) {
+            return PRODUCT_LIMITED;
+        }
+        if (!venue.bucket.TryAcquire(now)) {
+            if (product != nullptr) product->Refund();
+            return VENUE_LIMITED;
+        }
+        return ACQUIRED;
+    }
+
+    const std::deque<ExecutionOrder<T>>* FindQueue(const Venue& venue, const std::string& productId) const {
+        auto it = venue.queueIndex.find(productId);
+        return it != venue.queueIndex.end() ? &venue.queues[it->second] : nullptr;
+    }
+
+    std::deque<ExecutionOrder<T>>& QueueFor(Venue& venue, const std::string& productId) {
+        auto [it, inserted] = venue.queueIndex.try_emplace(productId, venue.queues.size());
+        if (inserted) {
+            venue.queues.emplace_back();
+        }
+        return venue.queues[it->second];
+    }
+
+    void Drop(const ExecutionOrder<T>& order) {
+        if (dropHandler) dropHandler(order);
+    }
+
+    TokenBucket* ProductBucket(const std::string& productId) {
+        if (productRate <= 0.0) return nullptr;
+        auto it = productBuckets.find(productId);
+        if (it == productBuckets.end()) {
+            it = productBuckets.try_emplace(productId, productRate, productBurst).first;
+        }
+        return &it->second;
+    }
+
+    // Sends one pending order per product in turn, in arrival order within a product, until the venue runs out of
+    // tokens or every remaining product is at its own limit. Returns true once the venue has no pending orders.
+    template<typename Send>
+    bool Drain(Venue& venue, Market market, long long now, Send& send) {
+        const size_t count = venue.queues.size();
+        bool progress = true;
+        while (venue.pendingCount > 0 && progress) {
+            progress = false;
+            for (size_t step = 0; step < count && venue.pendingCount > 0; ++step) {
+                size_t index = venue.cursor;
+                std::deque<ExecutionOrder<T>>& queue = venue.queues[index];
+                if (queue.empty()) {
+                    venue.cursor = (index + 1) % count;
+                    continue;
+                }
+                Acquisition acquired = TryAcquire(venue, queue.front(), now);
+                if (acquired == VENUE_LIMITED) {
+                    return false;
+                }
+                venue.cursor = (index + 1) % count;
+                if (acquired == PRODUCT_LIMITED) {
+                    continue;
+                }
+                send(queue.front(), market);
+                queue.pop_front();
+                --venue.pendingCount;
+                progress = true;
+            }
+        }
+        return venue.pendingCount == 0;
+    }
+
+    ThrottlePolicy policy;
+    const IClock& clock;
+    std::array<Venue, 3> venues;    // indexed by Market
+    double productRate = 0.0;
+    long productBurst = 1;
+    std::unordered_map<std::string, TokenBucket> productBuckets;
+    long throttled = 0;
+    long rejected = 0;
+    long conflated = 0;
+    std::function<void(const ExecutionOrder<T>&)> dropHandler;
+};
+
+#endif
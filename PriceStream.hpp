@@ -10,6 +10,7 @@
 // - GetProduct: Returns the product associated with the price stream.
 // - GetBidOrder: Retrieves the bid order of the price stream.
 // - GetOfferOrder: Retrieves the offer order of the price stream.
+// - GetEventTime: Returns the event time of the price the stream was built from, or 0 when unknown.
 //
 // @operators
 // - operator<<: Provides a formatted output of the price stream, including product ID and order details.
@@ -32,14 +33,15 @@ class PriceStream : public IPriceStream<T>
 {
 public:
     PriceStream() = default; 
-    PriceStream(const T &product, const PriceStreamOrder &bidOrder, const PriceStreamOrder &offerOrder)
-        : product(product), bidOrder(bidOrder), offerOrder(offerOrder) {}
+    PriceStream(const T &product, const PriceStreamOrder &bidOrder, const PriceStreamOrder &offerOrder, long long eventTime = 0)
+        : product(product), bidOrder(bidOrder), offerOrder(offerOrder), eventTime(eventTime) {}
 
     virtual ~PriceStream() = default;
 
     const T& GetProduct() const override { return product; }
     const PriceStreamOrder& GetBidOrder() const override { return bidOrder; }
     const PriceStreamOrder& GetOfferOrder() const override { return offerOrder; }
+    long long GetEventTime() const { return eventTime; }
 
     friend std::ostream& operator<<(std::ostream& output, const PriceStream<T>& priceStream)
     {
@@ -58,6 +60,7 @@ private:
     T product;
     PriceStreamOrder bidOrder;
     PriceStreamOrder offerOrder;
+    long long eventTime = 0;
 };
 
 #endif
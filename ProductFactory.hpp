@@ -7,7 +7,8 @@
 //              and create products dynamically.
 //
 // @methods
-// - QueryProduct: Retrieves and constructs a product object based on its CUSIP.
+// - QueryProduct: Retrieves a copy of the product for a CUSIP from the pre-built product table.
+// - Preload: Builds the product table ahead of the first query.
 //
 // @types
 // - ProductCtor: A function type representing a constructor for a product.
@@ -30,14 +31,31 @@ public:
     using ProductCtor = std::function<T()>;
 
     static T QueryProduct(const std::string& cusip) {
-        auto it = GetProductConstructors().find(cusip);
-        if (it == GetProductConstructors().end()) {
+        const auto& products = GetProducts();
+        auto it = products.find(cusip);
+        if (it == products.end()) {
             throw std::invalid_argument("Unknown CUSIP: " + cusip);
         }
-        return it->second();
+        return it->second;
+    }
+
+    static void Preload() {
+        GetProducts();
     }
 
 private:
+    // Each product is constructed once, so queries copy a ready object instead of re-parsing dates.
+    static const std::map<std::string, T>& GetProducts() {
+        static const std::map<std::string, T> products = [] {
+            std::map<std::string, T> table;
+            for (const auto& [cusip, ctor] : GetProductConstructors()) {
+                table.emplace(cusip, ctor());
+            }
+            return table;
+        }();
+        return products;
+    }
+
     static const std::map<std::string, ProductCtor>& GetProductConstructors() {
         static std::map<std::string, ProductCtor> productConstructors = {
             {"91282CAV3", []() { return Bond("91282CAV3", CUSIP, "US2Y", 0.04500, from_string("2026/11/30")); }},
@@ -0,0 +1,213 @@
+// RfqAnalytics.hpp
+//
+// Maintains live RFQ statistics by client, product and size bucket as inquiries change state.
+//
+// @class RfqStats
+// @description Counters of one slice of the RFQ flow: inquiries per state, and a LatencyHistogram of response
+//              times from receiving an inquiry to quoting it. The state counters are atomics written with relaxed
+//              stores by the single pipeline thread. The histogram sits behind a sequence number (a seqlock): the
+//              writer makes it odd while recording, and a reader copies the histogram and retries if the number
+//              changed. Readers on other threads can therefore take snapshots at any time without a lock. A
+//              snapshot is consistent per counter and for the histogram, not across them.
+//
+// @class RfqSnapshot
+// @description A plain copy of an RfqStats for reporting, with the hit ratio (done / quoted) and response-time
+//              percentiles.
+//
+// @class RfqAnalytics
+// @description A listener on InquiryService that updates the stats of the inquiry's client, product and size
+//              bucket on every state change. Stats live in fixed-size arrays; a client or product is given a slot
+//              the first time it appears and those beyond capacity share an "OTHER" slot, so every update is O(1).
+//              Slot names are published before the slot count, so a reader that sees a slot also sees its name.
+//              The response time is measured on the analytics clock: an inquiry is stamped when it is received,
+//              and the stamp is taken off again when it is quoted. Size buckets are the inquiry size buckets
+//              shared with InquiryQuoter.
+//
+// @methods (RfqAnalytics)
+// - ProcessAdd: Counts one state change and, for a quote, its response time.
+// - GetClientSnapshot / GetProductSnapshot: Snapshot of a client or product; zeros if it has not been seen.
+// - GetSizeSnapshot: Snapshot of a size bucket.
+// - GetTotalSnapshot: Snapshot of all inquiries.
+// - GetClients / GetProducts: Names seen so far, in order of first appearance.
+// - GetSizeBucket: Returns the bucket of a quantity.
+// - GetOpenCount: Returns the number of received inquiries not yet quoted or closed.
+
+#ifndef RFQANALYTICS_HPP
+#define RFQANALYTICS_HPP
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "soa.hpp"
+#include "inquiryservice.hpp"
+#include "InquiryQuoter.hpp"
+#include "LatencyHistogram.hpp"
+#include "IClock.hpp"
+#include "Clocks.hpp"
+
+struct RfqSnapshot {
+    long received = 0;
+    long quoted = 0;
+    long done = 0;
+    long rejected = 0;
+    long customerRejected = 0;
+    long responses = 0;
+    double meanResponseNanos = 0.0;
+    long long p50ResponseNanos = 0;
+    long long p99ResponseNanos = 0;
+
+    double HitRatio() const { return quoted == 0 ? 0.0 : static_cast<double>(done) / quoted; }
+};
+
+class RfqStats {
+public:
+    static constexpr int STATE_COUNT = CUSTOMER_REJECTED + 1;
+
+    void Count(InquiryState state) { Increment(states[state], 1); }
+
+    void RecordResponse(long long nanos) {
+        unsigned long sequence = responseSequence.load(std::memory_order_relaxed);
+        responseSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        responseTimes.Record(nanos);
+        responseSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    RfqSnapshot Snapshot() const {
+        RfqSnapshot snapshot;
+        snapshot.received = Load(states[RECEIVED]);
+        snapshot.quoted = Load(states[QUOTED]);
+        snapshot.done = Load(states[DONE]);
+        snapshot.rejected = Load(states[REJECTED]);
+        snapshot.customerRejected = Load(states[CUSTOMER_REJECTED]);
+
+        LatencyHistogram copy;
+        for (;;) {
+            unsigned long before = responseSequence.load(std::memory_order_acquire);
+            if (before & 1) continue;
+            copy = responseTimes;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (responseSequence.load(std::memory_order_relaxed) == before) break;
+        }
+        snapshot.responses = static_cast<long>(copy.Count());
+        if (snapshot.responses > 0) {
+            snapshot.meanResponseNanos = copy.Mean();
+            snapshot.p50ResponseNanos = copy.Percentile(50.0);
+            snapshot.p99ResponseNanos = copy.Percentile(99.0);
+        }
+        return snapshot;
+    }
+
+private:
+    // Single writer: a relaxed load and store is enough and avoids a locked read-modify-write.
+    static void Increment(std::atomic<long>& counter, long amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static long Load(const std::atomic<long>& counter) { return counter.load(std::memory_order_relaxed); }
+
+    std::array<std::atomic<long>, STATE_COUNT> states{};
+    std::atomic<unsigned long> responseSequence{0};   // odd while the writer is recording
+    LatencyHistogram responseTimes;
+};
+
+template<typename T>
+class RfqAnalytics : public ServiceListener<Inquiry<T>> {
+public:
+    static constexpr size_t MAX_CLIENTS = 64;
+    static constexpr size_t MAX_PRODUCTS = 64;
+    static constexpr size_t SIZE_BUCKETS = INQUIRY_SIZE_LIMITS.size() + 1;
+
+    explicit RfqAnalytics(const IClock& _clock = RealTimeClock::Instance()) : clock(_clock) {
+        clients.names[MAX_CLIENTS] = "OTHER";
+        products.names[MAX_PRODUCTS] = "OTHER";
+    }
+
+    void ProcessAdd(Inquiry<T>& data) override {
+        RfqStats& client = clients.Slot(data.GetClient().empty() ? UNKNOWN_CLIENT : data.GetClient());
+        RfqStats& product = products.Slot(data.GetProduct().GetProductId());
+        RfqStats& size = sizes[GetSizeBucket(data.GetQuantity())];
+        InquiryState state = data.GetState();
+        for (RfqStats* stats : { &client, &product, &size, &total }) {
+            stats->Count(state);
+        }
+        if (state == RECEIVED) {
+            receivedAt.insert_or_assign(data.GetInquiryId(), clock.NowNanos());
+            return;
+        }
+        auto received = receivedAt.find(data.GetInquiryId());
+        if (received == receivedAt.end()) {
+            return;
+        }
+        if (state == QUOTED) {
+            long long response = clock.NowNanos() - received->second;
+            for (RfqStats* stats : { &client, &product, &size, &total }) {
+                stats->RecordResponse(response);
+            }
+        }
+        receivedAt.erase(received);
+    }
+
+    void ProcessRemove(Inquiry<T>& data) override {}
+    void ProcessUpdate(Inquiry<T>& data) override { ProcessAdd(data); }
+
+    RfqSnapshot GetClientSnapshot(std::string_view client) const { return clients.Snapshot(client); }
+    RfqSnapshot GetProductSnapshot(std::string_view productId) const { return products.Snapshot(productId); }
+    RfqSnapshot GetSizeSnapshot(size_t bucket) const { return sizes.at(bucket).Snapshot(); }
+    RfqSnapshot GetTotalSnapshot() const { return total.Snapshot(); }
+    std::vector<std::string> GetClients() const { return clients.Names(); }
+    std::vector<std::string> GetProducts() const { return products.Names(); }
+    size_t GetOpenCount() const { return receivedAt.size(); }
+
+    static size_t GetSizeBucket(long quantity) { return InquirySizeBucket(quantity); }
+
+private:
+    static constexpr const char* UNKNOWN_CLIENT = "UNKNOWN";
+
+    // Named slots plus a shared overflow slot at index Capacity.
+    // Stats are on the heap: each holds a full histogram, too much for the stack of the owning services.
+    template<size_t Capacity>
+    struct SlotTable {
+        std::unique_ptr<RfqStats[]> stats{new RfqStats[Capacity + 1]};
+        std::array<std::string, Capacity + 1> names;
+        std::unordered_map<std::string, size_t> index;     // writer only
+        std::atomic<size_t> count{0};
+
+        RfqStats& Slot(const std::string& name) {
+            auto it = index.find(name);
+            if (it != index.end()) return stats[it->second];
+            size_t slot = count.load(std::memory_order_relaxed);
+            if (slot == Capacity) return stats[Capacity];
+            names[slot] = name;
+            index.emplace(name, slot);
+            count.store(slot + 1, std::memory_order_release);
+            return stats[slot];
+        }
+
+        RfqSnapshot Snapshot(std::string_view name) const {
+            size_t seen = count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < seen; ++i) {
+                if (names[i] == name) return stats[i].Snapshot();
+            }
+            return name == names[Capacity] ? stats[Capacity].Snapshot() : RfqSnapshot{};
+        }
+
+        std::vector<std::string> Names() const {
+            size_t seen = count.load(std::memory_order_acquire);
+            return std::vector<std::string>(names.begin(), names.begin() + seen);
+        }
+    };
+
+    const IClock& clock;
+    SlotTable<MAX_CLIENTS> clients;
+    SlotTable<MAX_PRODUCTS> products;
+    std::array<RfqStats, SIZE_BUCKETS> sizes;
+    RfqStats total;
+    std::unordered_map<std::string, long long> receivedAt;     // receipt time of each open inquiry, writer only
+};
+
+#endif
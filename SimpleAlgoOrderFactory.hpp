@@ -7,7 +7,8 @@
 //              generating execution orders with basic logic based on the best bid-offer spread.
 //
 // @methods
-// - CreateExecutionOrder: Generates an execution order based on the provided order book and a counter.
+// - CreateExecutionOrder: Generates an execution order based on the best bid and offer and a counter.
+// - GetStrategyName: Returns "SimpleCross".
 //
 // @logic
 // - If the bid-offer spread is narrow (<= 1/128), alternates between placing BID and OFFER orders.
@@ -25,15 +26,15 @@
 #include "RandomUtils.hpp"
 #include <memory>
 
-template<typename T>
-class SimpleAlgoOrderFactory : public IAlgoOrderFactory<T> {
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class SimpleAlgoOrderFactory : public IAlgoOrderFactory<T, Depth> {
 public:
-    std::unique_ptr<ExecutionOrder<T>> CreateExecutionOrder(const OrderBook<T>& orderBook, long count) override {
-        T product = orderBook.GetProduct();
+    using IAlgoOrderFactory<T, Depth>::CreateExecutionOrder;
+
+    std::unique_ptr<ExecutionOrder<T>> CreateExecutionOrder(const T& product, const BidOffer& bidOffer, long count) override {
         std::string orderId = "Algo" + RandomUtils::GenerateRandomId(11);
         std::string parentOrderId = "AlgoParent" + RandomUtils::GenerateRandomId(5);
 
-        BidOffer bidOffer = orderBook.BestBidOffer();
         Order bid = bidOffer.GetBidOrder();
         Order offer = bidOffer.GetOfferOrder();
         double bidPrice = bid.GetPrice();
@@ -68,6 +69,10 @@ public:
 
         return std::make_unique<ExecutionOrder<T>>(product, side, orderId, orderType, price, visibleQuantity, hiddenQuantity, parentOrderId, isChildOrder);
     }
+
+    std::string GetStrategyName() const override {
+        return "SimpleCross";
+    }
 };
 
 #endif
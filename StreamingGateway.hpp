@@ -0,0 +1,148 @@
+// StreamingGateway.hpp
+//
+// Streams tiered client quotes from the streaming service, encoding each tier's message once for all its clients.
+//
+// @class StreamingGateway
+// @description Listens to StreamingService. For each price stream it computes every tier's quote in one pass over
+//              the tier parameters, which are kept as separate arrays so the pass vectorizes. Each tier's message is
+//              encoded once into a buffer owned by the gateway, and the same bytes are handed to every client sink
+//              (see ClientSinks.hpp) subscribed to the tier. The cost per update grows with the number of tiers;
+//              each extra client adds only one Write call on the shared buffer. A tier widens the stream's
+//              half-spread by a multiplier plus a fixed amount, and caps the quoted size. Tier prices are rounded
+//              away from the mid to the 1/256 tick (bid down, offer up), so a tier is never tighter than its width.
+//
+// @format
+// - <CUSIP>,<tier>,<bid>,<bidSize>,<offer>,<offerSize>\n, with prices in fractional notation.
+//
+// @methods (StreamingGateway)
+// - AddTier: Adds a tier with its spread multiplier, extra half-spread in price points and maximum size.
+// - Subscribe / Unsubscribe: Attach or detach a client sink to a tier.
+// - Publish: Computes, encodes and fans out every tier for one price stream.
+// - GetListener: Listener to register on the streaming service.
+// - GetEncodedCount: Returns the number of tier messages encoded.
+// - GetDeliveredCount: Returns the number of messages handed to sinks.
+
+#ifndef STREAMINGGATEWAY_HPP
+#define STREAMINGGATEWAY_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "soa.hpp"
+#include "ClientSinks.hpp"
+#include "PriceStream.hpp"
+#include "PriceUtils.hpp"
+
+template<typename T>
+class StreamingGatewayListener;
+
+template<typename T>
+class StreamingGateway {
+public:
+    StreamingGateway() : listener(std::make_unique<StreamingGatewayListener<T>>(this)) {}
+
+    size_t AddTier(const std::string& name, double spreadMultiplier, double extraHalfSpread, long maxSize) {
+        names.push_back(name);
+        multipliers.push_back(spreadMultiplier);
+        extras.push_back(extraHalfSpread);
+        maxSizes.push_back(maxSize);
+        bids.push_back(0.0);
+        offers.push_back(0.0);
+        sizes.push_back(0);
+        buffers.emplace_back();
+        clients.emplace_back();
+        return names.size() - 1;
+    }
+
+    void Subscribe(IClientSink* sink, const std::string& tier) {
+        clients[TierIndex(tier)].push_back(sink);
+    }
+
+    void Unsubscribe(IClientSink* sink, const std::string& tier) {
+        auto& tierClients = clients[TierIndex(tier)];
+        tierClients.erase(std::remove(tierClients.begin(), tierClients.end(), sink), tierClients.end());
+    }
+
+    void Publish(const PriceStream<T>& priceStream) {
+        double bid = priceStream.GetBidOrder().GetPrice();
+        double offer = priceStream.GetOfferOrder().GetPrice();
+        double mid = (bid + offer) / 2.0;
+        double halfSpread = (offer - bid) / 2.0;
+        long size = std::min(priceStream.GetBidOrder().GetVisibleQuantity(), priceStream.GetOfferOrder().GetVisibleQuantity());
+
+        // One pass over the tier arrays; no branches, so the compiler can vectorize it.
+        size_t tierCount = names.size();
+        for (size_t i = 0; i < tierCount; ++i) {
+            double width = halfSpread * multipliers[i] + extras[i];
+            bids[i] = std::floor((mid - width) * TICKS) / TICKS;
+            offers[i] = std::ceil((mid + width) * TICKS) / TICKS;
+            sizes[i] = std::min(size, maxSizes[i]);
+        }
+
+        const std::string& productId = priceStream.GetProduct().GetProductId();
+        for (size_t i = 0; i < tierCount; ++i) {
+            if (clients[i].empty()) continue;
+            std::string& buffer = buffers[i];
+            buffer.clear();
+            buffer.append(productId).append(",").append(names[i]).append(",")
+                  .append(PriceUtils::Price2Frac(bids[i])).append(",").append(std::to_string(sizes[i])).append(",")
+                  .append(PriceUtils::Price2Frac(offers[i])).append(",").append(std::to_string(sizes[i])).append("\n");
+            ++encoded;
+
+            std::string_view message(buffer);
+            for (IClientSink* sink : clients[i]) {
+                sink->Write(message);
+            }
+            delivered += static_cast<long>(clients[i].size());
+        }
+    }
+
+    StreamingGatewayListener<T>* GetListener() { return listener.get(); }
+    long GetEncodedCount() const { return encoded; }
+    long GetDeliveredCount() const { return delivered; }
+
+private:
+    static constexpr double TICKS = 256.0;
+
+    size_t TierIndex(const std::string& tier) const {
+        auto it = std::find(names.begin(), names.end(), tier);
+        if (it == names.end()) {
+            throw std::invalid_argument("Unknown streaming tier: " + tier);
+        }
+        return static_cast<size_t>(it - names.begin());
+    }
+
+    // Tier parameters and per-update results, one array per field.
+    std::vector<std::string> names;
+    std::vector<double> multipliers;
+    std::vector<double> extras;
+    std::vector<long> maxSizes;
+    std::vector<double> bids;
+    std::vector<double> offers;
+    std::vector<long> sizes;
+
+    std::vector<std::string> buffers;                  // one reusable encode buffer per tier
+    std::vector<std::vector<IClientSink*>> clients;    // sinks subscribed to each tier, not owned
+    std::unique_ptr<StreamingGatewayListener<T>> listener;
+    long encoded = 0;
+    long delivered = 0;
+};
+
+template<typename T>
+class StreamingGatewayListener : public ServiceListener<PriceStream<T>> {
+public:
+    explicit StreamingGatewayListener(StreamingGateway<T>* _gateway) : gateway(_gateway) {}
+
+    void ProcessAdd(PriceStream<T>& data) override { gateway->Publish(data); }
+    void ProcessRemove(PriceStream<T>& data) override {}
+    void ProcessUpdate(PriceStream<T>& data) override { gateway->Publish(data); }
+
+private:
+    StreamingGateway<T>* gateway;
+};
+
+#endif
@@ -0,0 +1,297 @@
+// TcaService.hpp
+//
+// Measures execution quality of algo orders by joining each order's arrival market state with its fill.
+//
+// @class TcaStats
+// @description Running, quantity-weighted execution cost aggregate for one product, strategy or venue. Updating it
+//              is O(1) and it never stores individual fills. Costs are signed so that positive means worse than the
+//              reference for the order's side.
+//              - Slippage: fill price against the order's limit/decision price.
+//              - Implementation shortfall: fill price against the arrival mid, in price points times quantity.
+//              - Spread capture: share of the arrival half-spread earned, where +1 is a fill at the near touch
+//                (buying on the bid) and -1 is paying the full half-spread (buying on the offer).
+//
+// @class TcaService
+// @description Captures the arrival mid and spread from MarketDataService (falling back to PricingService) when
+//              AlgoExecutionService creates an order. The arrival is held until ExecutionService sends the order;
+//              an order the throttle drops takes its arrival with it, so only sent orders wait for a fill. It
+//              joins the fill booked in TradeBookingService under the same id and folds the result into per-product, per-strategy and per-venue TcaStats. Keyed on
+//              "product:<id>", "strategy:<name>" or "venue:<name>". Listeners receive a ProcessUpdate with the
+//              product aggregate after every fill.
+//
+// @methods (TcaService)
+// - GetData / TryGet: Retrieves an aggregate by key.
+// - AttachAlgoExecution: Registers on an algo execution service and tags its orders with its strategy name.
+//                        Attach before the execution service listener so arrivals are captured before the fill.
+// - AttachExecution: Registers on the execution service to learn which orders are sent or dropped. Attach before
+//                    the trade booking listener so a sent order is known before its fill.
+// - GetTradeListener: Listener to register on the trade booking service.
+// - RecordArrival: Captures the arrival state of a new algo order.
+// - RecordSent: Moves an order's arrival to the orders waiting for a fill.
+// - RecordDropped: Forgets the arrival of an order that was never sent.
+// - RecordFill: Joins a booked trade with its arrival and updates the aggregates.
+// - GetPendingCount: Returns the number of sent orders still waiting for a fill.
+// - GetUnsentCount: Returns the number of created orders not yet sent or dropped.
+// - Reserve: Pre-sizes the arrival tables.
+
+#ifndef TCASERVICE_HPP
+#define TCASERVICE_HPP
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "soa.hpp"
+#include "pricingservice.hpp"
+#include "marketdataservice.hpp"
+#include "tradebookingservice.hpp"
+#include "AlgoExecutionService.hpp"
+
+class TcaStats {
+public:
+    TcaStats() = default;
+    explicit TcaStats(std::string _name) : name(std::move(_name)) {}
+
+    void Add(long quantity, double slippage, double shortfall, double spreadCapture, bool hasSpread) {
+        ++fills;
+        totalQuantity += quantity;
+        slippageSum += slippage * quantity;
+        shortfallSum += shortfall * quantity;
+        if (hasSpread) {
+            spreadCaptureSum += spreadCapture * quantity;
+            spreadQuantity += quantity;
+        }
+    }
+
+    const std::string& GetName() const { return name; }
+    long GetFills() const { return fills; }
+    long GetQuantity() const { return totalQuantity; }
+    double GetAverageSlippage() const { return totalQuantity > 0 ? slippageSum / totalQuantity : 0.0; }
+    double GetAverageShortfall() const { return totalQuantity > 0 ? shortfallSum / totalQuantity : 0.0; }
+    double GetShortfall() const { return shortfallSum; }
+    double GetAverageSpreadCapture() const { return spreadQuantity > 0 ? spreadCaptureSum / spreadQuantity : 0.0; }
+
+    friend ostream& operator<<(ostream& output, const TcaStats& stats) {
+        output << stats.name << "," << stats.fills << "," << stats.totalQuantity << "," << stats.GetAverageSlippage()
+               << "," << stats.GetAverageShortfall() << "," << stats.GetAverageSpreadCapture();
+        return output;
+    }
+
+private:
+    std::string name;
+    long fills = 0;
+    long totalQuantity = 0;
+    double slippageSum = 0.0;
+    double shortfallSum = 0.0;
+    double spreadCaptureSum = 0.0;
+    long spreadQuantity = 0;
+};
+
+template<typename T, std::size_t Depth>
+class TcaOrderListener;
+
+template<typename T, std::size_t Depth>
+class TcaExecutionListener;
+
+template<typename T>
+class TcaTradeListener;
+
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class TcaService : public Service<std::string, TcaStats> {
+public:
+    // Either source may be null; the book is preferred because it is what the algo priced from.
+    TcaService(PricingService<T>* _pricingService, MarketDataService<T, Depth>* _marketDataService)
+        : pricingService(_pricingService), marketDataService(_marketDataService),
+          executionListener(std::make_unique<TcaExecutionListener<T, Depth>>(this)),
+          tradeListener(std::make_unique<TcaTradeListener<T>>(this)) {}
+
+    TcaStats& GetData(std::string key) override {
+        TcaStats* stats = TryGet(key);
+        if (stats == nullptr) {
+            throw std::runtime_error("Key not found: " + key);
+        }
+        return *stats;
+    }
+
+    TcaStats* TryGet(std::string_view key) override {
+        auto it = stats.find(std::string(key));
+        return it != stats.end() ? &it->second : nullptr;
+    }
+
+    void OnMessage(TcaStats& data) override {
+        // Aggregates are derived from orders and fills only.
+    }
+
+    void AddListener(ServiceListener<TcaStats>* listener) override {
+        listeners.push_back(listener);
+    }
+
+    const std::vector<ServiceListener<TcaStats>*>& GetListeners() const override {
+        return listeners;
+    }
+
+    void AttachAlgoExecution(AlgoExecutionService<T, Depth>& algoExecutionService) {
+        orderListeners.push_back(std::make_unique<TcaOrderListener<T, Depth>>(this, algoExecutionService.GetStrategyName()));
+        algoExecutionService.AddListener(orderListeners.back().get());
+    }
+
+    void AttachExecution(ExecutionService<T>& executionService) {
+        executionService.AddListener(executionListener.get());
+    }
+
+    TcaTradeListener<T>* GetTradeListener() { return tradeListener.get(); }
+
+    void RecordArrival(const AlgoExecution<T>& algoExecution, const std::string& strategy) {
+        const ExecutionOrder<T>& order = algoExecution.GetExecutionOrder();
+        Arrival arrival;
+        arrival.side = order.GetSide();
+        arrival.orderPrice = order.GetPrice();
+        arrival.strategy = strategy;
+        arrival.venue = VenueName(algoExecution.GetMarket());
+
+        const std::string& productId = order.GetProduct().GetProductId();
+        if (marketDataService != nullptr) {
+            if (const auto* book = marketDataService->TryGet(productId)) {
+                BidOffer top = book->BestBidOffer();
+                arrival.mid = (top.GetBidOrder().GetPrice() + top.GetOfferOrder().GetPrice()) / 2.0;
+                arrival.spread = top.GetOfferOrder().GetPrice() - top.GetBidOrder().GetPrice();
+                arrival.hasMid = true;
+            }
+        }
+        if (!arrival.hasMid && pricingService != nullptr) {
+            if (const Price<T>* price = pricingService->TryGet(productId)) {
+                arrival.mid = price->GetMid();
+                arrival.spread = price->GetBidOfferSpread();
+                arrival.hasMid = true;
+            }
+        }
+        unsent.insert_or_assign(order.GetOrderId(), std::move(arrival));
+    }
+
+    void RecordSent(const ExecutionOrder<T>& order) {
+        auto node = unsent.extract(order.GetOrderId());
+        if (!node.empty()) {
+            pending.insert_or_assign(order.GetOrderId(), std::move(node.mapped()));
+        }
+    }
+
+    void RecordDropped(const ExecutionOrder<T>& order) { unsent.erase(order.GetOrderId()); }
+
+    void RecordFill(const Trade<T>& trade) {
+        auto it = pending.find(trade.GetTradeId());
+        if (it == pending.end()) return;
+        const Arrival& arrival = it->second;
+
+        double sign = arrival.side == BID ? 1.0 : -1.0;
+        double fill = trade.GetPrice();
+        double slippage = sign * (fill - arrival.orderPrice);
+        double shortfall = arrival.hasMid ? sign * (fill - arrival.mid) : 0.0;
+        bool hasSpread = arrival.hasMid && arrival.spread > 0.0;
+        double spreadCapture = hasSpread ? sign * (arrival.mid - fill) / (arrival.spread / 2.0) : 0.0;
+        long quantity = trade.GetQuantity();
+
+        TcaStats& productStats = Stats("product:", trade.GetProduct().GetProductId());
+        productStats.Add(quantity, slippage, shortfall, spreadCapture, hasSpread);
+        Stats("strategy:", arrival.strategy).Add(quantity, slippage, shortfall, spreadCapture, hasSpread);
+        Stats("venue:", arrival.venue).Add(quantity, slippage, shortfall, spreadCapture, hasSpread);
+        pending.erase(it);
+
+        for (auto* listener : listeners) {
+            listener->ProcessUpdate(productStats);
+        }
+    }
+
+    size_t GetPendingCount() const { return pending.size(); }
+    size_t GetUnsentCount() const { return unsent.size(); }
+
+    void Reserve(size_t expectedOrders) {
+        unsent.reserve(expectedOrders);
+        pending.reserve(expectedOrders);
+    }
+
+private:
+    struct Arrival {
+        PricingSide side = BID;
+        double orderPrice = 0.0;
+        double mid = 0.0;
+        double spread = 0.0;
+        bool hasMid = false;
+        std::string strategy;
+        const char* venue = "";
+    };
+
+    static const char* VenueName(Market market) {
+        switch (market) {
+            case BROKERTEC: return "BROKERTEC";
+            case ESPEED: return "ESPEED";
+            case CME: return "CME";
+        }
+        return "UNKNOWN";
+    }
+
+    TcaStats& Stats(const char* prefix, const std::string& name) {
+        std::string key = prefix + name;
+        auto it = stats.find(key);
+        if (it == stats.end()) {
+            it = stats.emplace(key, TcaStats(key)).first;
+        }
+        return it->second;
+    }
+
+    PricingService<T>* pricingService;
+    MarketDataService<T, Depth>* marketDataService;
+    std::unordered_map<std::string, Arrival> unsent;
+    std::unordered_map<std::string, Arrival> pending;
+    std::unordered_map<std::string, TcaStats> stats;
+    std::vector<ServiceListener<TcaStats>*> listeners;
+    std::vector<std::unique_ptr<TcaOrderListener<T, Depth>>> orderListeners;
+    std::unique_ptr<TcaExecutionListener<T, Depth>> executionListener;
+    std::unique_ptr<TcaTradeListener<T>> tradeListener;
+};
+
+template<typename T, std::size_t Depth>
+class TcaOrderListener : public ServiceListener<AlgoExecution<T>> {
+public:
+    TcaOrderListener(TcaService<T, Depth>* _service, std::string _strategy)
+        : service(_service), strategy(std::move(_strategy)) {}
+
+    void ProcessAdd(AlgoExecution<T>& data) override { service->RecordArrival(data, strategy); }
+    void ProcessRemove(AlgoExecution<T>& data) override {}
+    void ProcessUpdate(AlgoExecution<T>& data) override {}
+
+private:
+    TcaService<T, Depth>* service;
+    std::string strategy;
+};
+
+template<typename T, std::size_t Depth>
+class TcaExecutionListener : public ServiceListener<ExecutionOrder<T>> {
+public:
+    explicit TcaExecutionListener(TcaService<T, Depth>* _service) : service(_service) {}
+
+    void ProcessAdd(ExecutionOrder<T>& data) override { service->RecordSent(data); }
+    void ProcessRemove(ExecutionOrder<T>& data) override { service->RecordDropped(data); }
+    void ProcessUpdate(ExecutionOrder<T>& data) override {}
+
+private:
+    TcaService<T, Depth>* service;
+};
+
+template<typename T>
+class TcaTradeListener : public ServiceListener<Trade<T>> {
+public:
+    template<typename Service>
+    explicit TcaTradeListener(Service* _service) : recordFill([_service](const Trade<T>& trade) { _service->RecordFill(trade); }) {}
+
+    void ProcessAdd(Trade<T>& data) override { recordFill(data); }
+    void ProcessRemove(Trade<T>& data) override {}
+    void ProcessUpdate(Trade<T>& data) override {}
+
+private:
+    std::function<void(const Trade<T>&)> recordFill;
+};
+
+#endif
@@ -8,12 +8,16 @@
 // @methods
 // - GetCurrentTime: Returns the current system time as a formatted string.
 // - FormatTime: Converts a given `time_point` to a formatted string with a customizable format.
+// - FormatNanos: Formats nanoseconds since the epoch like GetCurrentTime.
+// - ParseTimeNanos: Converts a "YYYY-MM-DD HH:MM:SS[.fff]" local timestamp to nanoseconds since the epoch.
+//                   Fields are read at fixed offsets without streams or locale, and the UTC offset is cached per
+//                   local hour, so a call costs a few nanoseconds.
 //
 // @constants
 // - Default format: "%Y-%m-%d %H:%M:%S" for `FormatTime`.
 //
 // @date 2024-12-20
-// @version 1.1
+// @version 1.2
 //
 // @author Junhao Yu
 
@@ -21,10 +25,12 @@
 #define TIMEUTILS_HPP
 
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <ctime>
+#include <stdexcept>
 
 class TimeUtils {
 public:
@@ -51,6 +57,78 @@ public:
         ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
         return ss.str();
     }
+
+    // Format nanoseconds since the epoch, as read from an IClock
+    static std::string FormatNanos(long long nanos) {
+        using namespace std::chrono;
+        return FormatTime(system_clock::time_point(duration_cast<system_clock::duration>(nanoseconds(nanos))));
+    }
+
+    // Parse a timestamp written by FormatTime back to nanoseconds since the epoch
+    static long long ParseTimeNanos(std::string_view text) {
+        // Digits are validated together: any non-digit makes its unsigned difference from '0' exceed 9.
+        static constexpr unsigned char DIGITS[] = {0, 1, 2, 3, 5, 6, 8, 9, 11, 12, 14, 15, 17, 18};
+        unsigned bad = text.size() < 19;
+        if (!bad) {
+            for (unsigned char i : DIGITS) bad |= static_cast<unsigned>(text[i] - '0') > 9;
+            bad |= (text[4] != '-') | (text[7] != '-') | (text[10] != ' ') | (text[13] != ':') | (text[16] != ':');
+        }
+        if (bad) {
+            throw std::invalid_argument("Invalid timestamp: " + std::string(text));
+        }
+
+        int year = Digits2(text, 0) * 100 + Digits2(text, 2);
+        long long localSeconds = DaysFromCivil(year, Digits2(text, 5), Digits2(text, 8)) * 86400LL
+                                 + Digits2(text, 11) * 3600LL + Digits2(text, 14) * 60LL + Digits2(text, 17);
+
+        // FormatTime writes exactly three fractional digits; other precisions take the general loop.
+        long long fraction = 0;
+        if (text.size() == 23 && text[19] == '.') {
+            fraction = ((text[20] - '0') * 100 + (text[21] - '0') * 10 + (text[22] - '0')) * 1000000LL;
+        } else if (text.size() > 20 && text[19] == '.') {
+            long long scale = 100000000LL;
+            for (std::size_t i = 20; i < text.size() && i < 29; ++i, scale /= 10) {
+                fraction += (text[i] - '0') * scale;
+            }
+        }
+        return (localSeconds - LocalOffsetSeconds(localSeconds)) * 1000000000LL + fraction;
+    }
+
+private:
+    static int Digits2(std::string_view text, std::size_t at) {
+        return (text[at] - '0') * 10 + (text[at + 1] - '0');
+    }
+
+    // Days since 1970-01-01 of a proleptic Gregorian date, without any table or library call.
+    static long long DaysFromCivil(int year, int month, int day) {
+        year -= month <= 2;
+        long long era = (year >= 0 ? year : year - 399) / 400;
+        unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+        unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + static_cast<long long>(dayOfEra) - 719468;
+    }
+
+    // Local time minus UTC for a local wall-clock time. Offsets only change on hour boundaries, so the last hour
+    // looked up is cached and mktime runs once per hour of data.
+    static long long LocalOffsetSeconds(long long localSeconds) {
+        thread_local long long cachedHour = -1;
+        thread_local long long cachedOffset = 0;
+        long long hour = localSeconds / 3600;
+        if (hour != cachedHour) {
+            time_t asUtc = static_cast<time_t>(hour * 3600);
+            tm fields;
+#ifdef _WIN32
+            gmtime_s(&fields, &asUtc);
+#else
+            gmtime_r(&asUtc, &fields);
+#endif
+            fields.tm_isdst = -1;
+            cachedOffset = hour * 3600 - static_cast<long long>(std::mktime(&fields));
+            cachedHour = hour;
+        }
+        return cachedOffset;
+    }
 };
 
 #endif
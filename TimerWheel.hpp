@@ -0,0 +1,281 @@
+// TimerWheel.hpp
+//
+// Schedules callbacks at future times for every time-driven behaviour in the trading system.
+//
+// @class TimerWheel
+// @description A hierarchical timing wheel with four levels of 256 slots. With the default 1 ms tick it spans about
+//              49 days; later timers are parked in the top level and re-filed when it turns. Each slot is an
+//              intrusive doubly linked list over a node pool, so scheduling and cancelling a timer are O(1) and
+//              allocate nothing once the pool has grown. Advancing only visits occupied slots and jumps over empty
+//              stretches, so a large gap in replay time costs a few hundred steps at most.
+//
+//              The wheel is driven either by Poll, which reads its IClock, or by Advance with an explicit time.
+//              With an EventTimeClock that the connectors advance, timers follow the timestamps of the input, so a
+//              replay fires them exactly where the live run did. Callbacks run on the thread that drives the wheel.
+//
+// @methods
+// - ScheduleAt: Runs a callback once at an absolute time in nanoseconds.
+// - ScheduleAfter: Runs a callback once after a delay in nanoseconds.
+// - SchedulePeriodic: Runs a callback every interval until it is cancelled. Periods missed within one Advance are
+//                     coalesced into a single run, so a jump in replay time does not replay every missed period.
+// - Cancel: Cancels a pending timer; returns false if it already fired or was cancelled.
+// - IsScheduled: Returns whether a timer is still pending.
+// - Advance: Moves the wheel to a time and runs every timer due by then; returns the number fired.
+// - Poll: Advances the wheel to the current time of its clock.
+// - Now: Returns the current time of the wheel in nanoseconds.
+// - GetPendingCount: Returns the number of pending timers.
+// - GetTickNanos: Returns the resolution of the wheel.
+
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include "IClock.hpp"
+#include "Clocks.hpp"
+
+using TimerId = std::uint64_t;
+constexpr TimerId INVALID_TIMER = 0;
+
+class TimerWheel {
+public:
+    using Callback = std::function<void()>;
+
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 8;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+    explicit TimerWheel(const IClock& _clock = RealTimeClock::Instance(), long long _tickNanos = 1000000)
+        : clock(_clock), tickNanos(_tickNanos), currentTick(0), pending(0) {
+        if (tickNanos <= 0) {
+            throw std::invalid_argument("Timer wheel tick must be positive");
+        }
+        currentTick = clock.NowNanos() / tickNanos;
+        heads.fill(NIL);
+        levelCounts.fill(0);
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    TimerId ScheduleAt(long long whenNanos, Callback callback) {
+        return Arm(TickFor(whenNanos), 0, std::move(callback));
+    }
+
+    TimerId ScheduleAfter(long long delayNanos, Callback callback) {
+        return Arm(TickFor(Now() + delayNanos), 0, std::move(callback));
+    }
+
+    TimerId SchedulePeriodic(long long intervalNanos, Callback callback) {
+        long long periodTicks = std::max(1LL, intervalNanos / tickNanos);
+        return Arm(currentTick + periodTicks, periodTicks, std::move(callback));
+    }
+
+    bool Cancel(TimerId id) {
+        // A one-shot timer that is running can no longer be cancelled; a periodic one is re-armed before it runs.
+        if (!IsScheduled(id)) return false;
+        Unlink(IndexOf(id));
+        Release(IndexOf(id));
+        return true;
+    }
+
+    bool IsScheduled(TimerId id) const {
+        std::int32_t index = IndexOf(id);
+        if (id == INVALID_TIMER || index < 0 || static_cast<size_t>(index) >= nodes.size()) return false;
+        const Node& node = nodes[index];
+        return node.generation == static_cast<std::uint32_t>(id >> 32) && node.list != NIL;
+    }
+
+    size_t Advance(long long nowNanos) {
+        long long targetTick = nowNanos / tickNanos;
+        advanceTarget = targetTick;
+        size_t fired = 0;
+        while (currentTick < targetTick) {
+            if (pending == 0) {
+                currentTick = targetTick;
+                break;
+            }
+            // Nothing can fire before the lowest occupied level next turns, so jump to just before that boundary.
+            int level = 0;
+            while (level < LEVELS - 1 && levelCounts[level] == 0) ++level;
+            if (level > 0) {
+                long long span = 1LL << (SLOT_BITS * level);
+                long long boundary = (currentTick | (span - 1)) + 1;
+                if (boundary > targetTick) {
+                    currentTick = targetTick;
+                    break;
+                }
+                currentTick = boundary - 1;
+            }
+            fired += Step();
+        }
+        return fired;
+    }
+
+    size_t Poll() {
+        return Advance(clock.NowNanos());
+    }
+
+    long long Now() const { return currentTick * tickNanos; }
+    size_t GetPendingCount() const { return pending; }
+    long long GetTickNanos() const { return tickNanos; }
+
+private:
+    static constexpr std::int32_t NIL = -1;
+    static constexpr std::int32_t FIRING = LEVELS * SLOTS;
+
+    struct Node {
+        long long expiryTick = 0;
+        long long periodTicks = 0;
+        std::int32_t prev = NIL;
+        std::int32_t next = NIL;
+        std::int32_t list = NIL;     // slot list holding the node, FIRING while due, NIL when idle
+        std::uint32_t generation = 1;
+        Callback callback;
+    };
+
+    static std::int32_t IndexOf(TimerId id) { return static_cast<std::int32_t>(static_cast<std::uint32_t>(id)); }
+
+    long long TickFor(long long whenNanos) const {
+        // Round up so a timer never fires early; a timer due now fires on the next tick.
+        long long tick = (whenNanos + tickNanos - 1) / tickNanos;
+        return tick > currentTick ? tick : currentTick + 1;
+    }
+
+    TimerId Arm(long long expiryTick, long long periodTicks, Callback callback) {
+        std::int32_t index;
+        if (!freeList.empty()) {
+            index = freeList.back();
+            freeList.pop_back();
+        } else {
+            index = static_cast<std::int32_t>(nodes.size());
+            nodes.emplace_back();
+        }
+        Node& node = nodes[index];
+        node.expiryTick = expiryTick;
+        node.periodTicks = periodTicks;
+        node.callback = std::move(callback);
+        ++pending;
+        File(index);
+        return (static_cast<TimerId>(node.generation) << 32) | static_cast<std::uint32_t>(index);
+    }
+
+    // Files a node into the level whose span covers its distance from the current tick.
+    void File(std::int32_t index) {
+        Node& node = nodes[index];
+        long long delta = node.expiryTick - currentTick;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1LL << (SLOT_BITS * (level + 1)))) ++level;
+        long long slotTick = node.expiryTick;
+        if (level == LEVELS - 1 && delta >= (1LL << (SLOT_BITS * LEVELS))) {
+            // Beyond the range of the wheel: park in the last slot the top level reaches and re-file from there.
+            slotTick = currentTick + (1LL << (SLOT_BITS * LEVELS)) - 1;
+        }
+        int slot = static_cast<int>((slotTick >> (SLOT_BITS * level)) & (SLOTS - 1));
+        Link(index, level * SLOTS + slot);
+    }
+
+    void Link(std::int32_t index, std::int32_t list) {
+        Node& node = nodes[index];
+        node.list = list;
+        node.prev = NIL;
+        node.next = heads[list];
+        if (node.next != NIL) nodes[node.next].prev = index;
+        heads[list] = index;
+        if (list < FIRING) ++levelCounts[list / SLOTS];
+    }
+
+    void Unlink(std::int32_t index) {
+        Node& node = nodes[index];
+        if (node.prev != NIL) nodes[node.prev].next = node.next;
+        else heads[node.list] = node.next;
+        if (node.next != NIL) nodes[node.next].prev = node.prev;
+        if (node.list < FIRING) --levelCounts[node.list / SLOTS];
+        node.list = NIL;
+        node.prev = node.next = NIL;
+    }
+
+    void Release(std::int32_t index) {
+        Node& node = nodes[index];
+        node.callback = nullptr;
+        ++node.generation;
+        if (node.generation == 0) node.generation = 1;
+        freeList.push_back(index);
+        --pending;
+    }
+
+    // Moves one tick forward, cascading higher levels as lower ones wrap, and runs the timers in the new slot.
+    size_t Step() {
+        ++currentTick;
+        for (int level = 1; level < LEVELS; ++level) {
+            if (((currentTick >> (SLOT_BITS * (level - 1))) & (SLOTS - 1)) != 0) break;
+            int slot = static_cast<int>((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1));
+            Cascade(level * SLOTS + slot);
+        }
+
+        // Due nodes move to the firing list so a callback can cancel any of them, including ones not yet run.
+        std::int32_t list = static_cast<std::int32_t>(currentTick & (SLOTS - 1));
+        while (heads[list] != NIL) {
+            std::int32_t index = heads[list];
+            Unlink(index);
+            Link(index, FIRING);
+        }
+
+        size_t fired = 0;
+        while (heads[FIRING] != NIL) {
+            std::int32_t index = heads[FIRING];
+            Unlink(index);
+            Node& node = nodes[index];
+            if (node.expiryTick > currentTick) {
+                File(index);
+                continue;
+            }
+            ++fired;
+            if (node.periodTicks > 0) {
+                // The callback is moved out while it runs so that cancelling itself does not destroy it mid-call.
+                std::uint32_t generation = node.generation;
+                node.expiryTick = currentTick + node.periodTicks;
+                if (node.expiryTick <= advanceTarget) {
+                    node.expiryTick += ((advanceTarget - node.expiryTick) / node.periodTicks + 1) * node.periodTicks;
+                }
+                File(index);
+                Callback callback = std::move(node.callback);
+                callback();
+                Node& rearmed = nodes[index];
+                if (rearmed.generation == generation) rearmed.callback = std::move(callback);
+            } else {
+                // The pool is a deque, so the node stays put if the callback schedules more timers.
+                node.callback();
+                Release(index);
+            }
+        }
+        return fired;
+    }
+
+    void Cascade(std::int32_t list) {
+        std::int32_t index = heads[list];
+        while (index != NIL) {
+            std::int32_t next = nodes[index].next;
+            Unlink(index);
+            File(index);
+            index = next;
+        }
+    }
+
+    const IClock& clock;
+    long long tickNanos;
+    long long currentTick;
+    long long advanceTarget = 0;
+    size_t pending;
+    std::deque<Node> nodes;
+    std::vector<std::int32_t> freeList;
+    std::array<std::int32_t, LEVELS * SLOTS + 1> heads;
+    std::array<size_t, LEVELS> levelCounts;
+};
+
+#endif
@@ -0,0 +1,306 @@
+// TraceRecorder.hpp
+//
+// Records per-message pipeline spans and exports them as Chrome/Perfetto trace-event JSON.
+//
+// @class TraceRecorder
+// @description Opt-in span recorder. Each thread appends completed spans to its own preallocated ring buffer,
+//              with no locks on the recording path. A full ring overwrites its oldest spans, so a long run
+//              keeps tracing and the file always holds each thread's most recent spans; the number overwritten
+//              is reported per thread and in total in the trace file. Registering a thread's buffer takes a
+//              lock once, the first time that thread records. Messages are sampled one in N at the pipeline
+//              entry point. Every span inside a sampled message is recorded, and spans of unsampled messages
+//              cost a thread-local flag check. The trace file is written on Flush (at shutdown) or after
+//              SIGUSR1 once the current message completes.
+//
+// @class StageTimings
+// @description Latency histograms per stage, keyed by span name. While a thread collects into one, every span
+//              on that thread is timed into it, sampled or not, whether or not tracing is enabled. Times are
+//              inclusive of nested stages.
+//
+// @class TraceSpan
+// @description RAII span for one stage. Records begin/end for the current message if it is sampled, and its
+//              duration into the thread's StageTimings if one is collecting.
+//
+// @class TraceMessageScope
+// @description RAII span for a pipeline entry point. Starts a new message and makes the sampling decision.
+//              When nested inside another message it behaves like a plain TraceSpan.
+//
+// @methods (TraceRecorder)
+// - Enable: Turns tracing on with an output file, a sampling interval, and a per-thread buffer capacity.
+// - IsEnabled: Returns whether tracing is on.
+// - Flush: Writes the spans held in every thread's ring to the output file.
+// - InstallSignalHandler: Requests a flush on SIGUSR1 (POSIX only).
+// - CollectStages: Starts timing the calling thread's spans into a StageTimings, or stops with nullptr.
+//
+// @macros
+// - TRACE_SPAN(name): Opens a TraceSpan for the enclosing scope.
+// - TRACE_MESSAGE(name): Opens a TraceMessageScope for the enclosing scope.
+//   Define TRADING_NO_TRACE to compile both out entirely.
+
+#ifndef TRACERECORDER_HPP
+#define TRACERECORDER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "LatencyHistogram.hpp"
+
+struct TraceEvent {
+    const char* name;
+    int64_t beginNanos;
+    int64_t endNanos;
+    uint64_t messageId;
+};
+
+class StageTimings {
+public:
+    // Span names are string literals, so the views stay valid.
+    void Record(const char* name, int64_t nanos) { histograms[name].Record(nanos); }
+    const std::map<std::string_view, LatencyHistogram>& GetHistograms() const { return histograms; }
+
+private:
+    std::map<std::string_view, LatencyHistogram> histograms;
+};
+
+class TraceRecorder {
+public:
+    static void Enable(const std::string& outputFile, unsigned sampleEvery = 1, size_t bufferCapacity = 1 << 18) {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.outputFile = outputFile;
+        state.sampleEvery = sampleEvery == 0 ? 1 : sampleEvery;
+        state.bufferCapacity = bufferCapacity == 0 ? 1 : bufferCapacity;
+        state.origin = std::chrono::steady_clock::now();
+        state.enabled.store(true, std::memory_order_release);
+    }
+
+    static bool IsEnabled() {
+        return GetState().enabled.load(std::memory_order_relaxed);
+    }
+
+    static void InstallSignalHandler() {
+#ifdef SIGUSR1
+        std::signal(SIGUSR1, [](int) { GetState().flushRequested.store(true, std::memory_order_relaxed); });
+#endif
+    }
+
+    static void CollectStages(StageTimings* timings) {
+        Context().stages = timings;
+    }
+
+    static void Flush() {
+        State& state = GetState();
+        if (!state.enabled.load(std::memory_order_acquire)) return;
+
+        std::lock_guard<std::mutex> lock(state.mutex);
+        std::ofstream out(state.outputFile);
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        uint64_t overwritten = 0;
+        std::vector<TraceEvent> events;
+        for (const auto& buffer : state.buffers) {
+            out << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                << ",\"args\":{\"name\":\"pipeline-" << buffer->threadIndex << "\"}}";
+            first = false;
+
+            uint64_t threadOverwritten = buffer->Snapshot(events, buffer.get() != Context().buffer);
+            for (const TraceEvent& e : events) {
+                out << ",\n{\"name\":\"" << e.name << "\",\"cat\":\"pipeline\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                    << ",\"ts\":" << e.beginNanos / 1000.0 << ",\"dur\":" << (e.endNanos - e.beginNanos) / 1000.0
+                    << ",\"args\":{\"msg\":" << e.messageId << "}}";
+            }
+            if (threadOverwritten > 0) {
+                out << ",\n{\"name\":\"overwritten_spans\",\"ph\":\"C\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                    << ",\"ts\":0,\"args\":{\"count\":" << threadOverwritten << "}}";
+            }
+            overwritten += threadOverwritten;
+        }
+        out << "\n],\"otherData\":{\"overwrittenSpans\":" << overwritten << ",\"sampleEvery\":" << state.sampleEvery << "}}\n";
+    }
+
+private:
+    friend class TraceSpan;
+    friend class TraceMessageScope;
+
+    // Ring of spans written by one thread. written counts every span ever appended, so the ring holds
+    // spans [written - capacity, written) and everything before was overwritten.
+    struct ThreadBuffer {
+        std::vector<TraceEvent> events;
+        std::atomic<uint64_t> written{0};
+        int threadIndex = 0;
+
+        void Push(const TraceEvent& event) {
+            uint64_t next = written.load(std::memory_order_relaxed);
+            events[next % events.size()] = event;
+            written.store(next + 1, std::memory_order_release);
+        }
+
+        // Copies the spans held in the ring, oldest first, and returns how many were overwritten. When called
+        // from another thread the owner may keep writing: spans it overwrote, or may be overwriting, while
+        // they were being copied are discarded.
+        uint64_t Snapshot(std::vector<TraceEvent>& out, bool concurrent) const {
+            uint64_t capacity = events.size();
+            uint64_t end = written.load(std::memory_order_acquire);
+            uint64_t begin = end > capacity ? end - capacity : 0;
+            out.clear();
+            for (uint64_t i = begin; i < end; ++i) {
+                out.push_back(events[i % capacity]);
+            }
+            uint64_t after = written.load(std::memory_order_acquire) + (concurrent ? 1 : 0);
+            uint64_t stale = after > capacity + begin ? std::min(after - capacity - begin, end - begin) : 0;
+            out.erase(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(stale));
+            return begin + stale;
+        }
+    };
+
+    struct State {
+        std::atomic<bool> enabled{false};
+        std::atomic<bool> flushRequested{false};
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        std::string outputFile;
+        unsigned sampleEvery = 1;
+        size_t bufferCapacity = 0;
+        std::chrono::steady_clock::time_point origin;
+    };
+
+    struct ThreadContext {
+        ThreadBuffer* buffer = nullptr;
+        StageTimings* stages = nullptr;
+        uint64_t messageCount = 0;
+        uint64_t currentMessage = 0;
+        int depth = 0;
+        bool sampled = false;
+    };
+
+    static State& GetState() {
+        static State state;
+        return state;
+    }
+
+    static ThreadContext& Context() {
+        static thread_local ThreadContext context;
+        return context;
+    }
+
+    static int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetState().origin).count();
+    }
+
+    static void Append(const char* name, int64_t begin, int64_t end) {
+        ThreadContext& context = Context();
+        if (context.buffer == nullptr) {
+            State& state = GetState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->events.resize(state.bufferCapacity);
+            buffer->threadIndex = static_cast<int>(state.buffers.size()) + 1;
+            context.buffer = buffer.get();
+            state.buffers.push_back(std::move(buffer));
+        }
+
+        context.buffer->Push(TraceEvent{name, begin, end, context.currentMessage});
+    }
+
+    // Times a span when tracing samples the current message or the thread collects stage timings.
+    static bool IsTimed(const ThreadContext& context) {
+        return context.stages != nullptr || (IsEnabled() && context.sampled);
+    }
+
+    static void Complete(const char* name, int64_t begin) {
+        int64_t end = Now();
+        ThreadContext& context = Context();
+        if (context.stages != nullptr) {
+            context.stages->Record(name, end - begin);
+        }
+        if (IsEnabled() && context.sampled) {
+            Append(name, begin, end);
+        }
+    }
+
+    static void CheckFlushRequest() {
+        State& state = GetState();
+        if (state.flushRequested.load(std::memory_order_relaxed)) {
+            state.flushRequested.store(false, std::memory_order_relaxed);
+            Flush();
+        }
+    }
+};
+
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* _name) : name(_name), begin(-1) {
+        if (TraceRecorder::IsTimed(TraceRecorder::Context())) {
+            begin = TraceRecorder::Now();
+        }
+    }
+
+    ~TraceSpan() {
+        if (begin >= 0) {
+            TraceRecorder::Complete(name, begin);
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    int64_t begin;
+};
+
+class TraceMessageScope {
+public:
+    explicit TraceMessageScope(const char* _name) : name(_name), begin(-1), active(TraceRecorder::IsEnabled()) {
+        TraceRecorder::ThreadContext& context = TraceRecorder::Context();
+        if (active && context.depth++ == 0) {
+            context.sampled = context.messageCount++ % TraceRecorder::GetState().sampleEvery == 0;
+            context.currentMessage = context.messageCount;
+        }
+        if (TraceRecorder::IsTimed(context)) {
+            begin = TraceRecorder::Now();
+        }
+    }
+
+    ~TraceMessageScope() {
+        if (begin >= 0) {
+            TraceRecorder::Complete(name, begin);
+        }
+        if (!active) return;
+        TraceRecorder::ThreadContext& context = TraceRecorder::Context();
+        if (--context.depth == 0) {
+            context.sampled = false;
+            TraceRecorder::CheckFlushRequest();
+        }
+    }
+
+    TraceMessageScope(const TraceMessageScope&) = delete;
+    TraceMessageScope& operator=(const TraceMessageScope&) = delete;
+
+private:
+    const char* name;
+    int64_t begin;
+    bool active;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+#ifdef TRADING_NO_TRACE
+#define TRACE_SPAN(name)
+#define TRACE_MESSAGE(name)
+#else
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_MESSAGE(name) TraceMessageScope TRACE_CONCAT(traceMessage_, __LINE__)(name)
+#endif
+
+#endif
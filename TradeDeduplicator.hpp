@@ -0,0 +1,262 @@
+// TradeDeduplicator.hpp
+//
+// Detects trade ids that were already booked, so re-reading overlapping trade files after a restart is idempotent.
+//
+// @class BlockedBloomFilter
+// @description A Bloom filter split into 64-byte blocks. One hash picks a block and eight bits are set in it, one
+//              in each 64-bit word, so a lookup touches a single cache line. Sized at about 12 bits per id, which
+//              gives a false-positive rate under 0.5%.
+//
+// @class FingerprintSet
+// @description An open-addressing hash set of 128-bit id fingerprints with linear probing. Slots are 16 bytes, so
+//              ids of any length are stored compactly and the set never allocates per id. Two independent 64-bit
+//              hashes make a collision between distinct ids practically impossible.
+//
+// @class TradeDeduplicator
+// @description Keeps two generations, each a Bloom filter in front of a fingerprint set. An id is a duplicate if
+//              either generation holds it. The Bloom filters answer the common new-id case without probing a set.
+//              The current generation is retired once its window of event time has passed or it reaches its
+//              capacity; the older one is then dropped. Ids are therefore remembered for at least one window
+//              (unless the capacity is hit first), and memory stays bounded by two generations. Only fingerprints
+//              are kept; the deduplicator holds no id strings and owns no state of its callers.
+//
+// @methods (TradeDeduplicator)
+// - Admit: Returns true and records the id if it is new, false if it is a duplicate.
+// - Contains: Returns whether an id is remembered, without recording it.
+// - GetDuplicateCount: Returns the number of duplicates rejected.
+// - GetRotationCount: Returns the number of generations retired.
+// - GetSize: Returns the number of ids remembered.
+
+#ifndef TRADEDEDUPLICATOR_HPP
+#define TRADEDEDUPLICATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Two independent 64-bit hashes of an id, computed in one pass over its bytes.
+struct IdFingerprint {
+    std::uint64_t high;
+    std::uint64_t low;
+
+    bool operator==(const IdFingerprint& other) const { return high == other.high && low == other.low; }
+
+    static IdFingerprint Of(std::string_view id) {
+        std::uint64_t h1 = 0x9E3779B97F4A7C15ULL ^ id.size();
+        std::uint64_t h2 = 0xC2B2AE3D27D4EB4FULL + id.size();
+        std::size_t i = 0;
+        for (; i + 8 <= id.size(); i += 8) {
+            std::uint64_t word;
+            std::memcpy(&word, id.data() + i, 8);
+            h1 = Mix(h1 ^ word);
+            h2 = Mix(h2 + word * 0x165667B19E3779F9ULL);
+        }
+        if (i < id.size()) {
+            std::uint64_t word = 0;
+            std::memcpy(&word, id.data() + i, id.size() - i);
+            h1 = Mix(h1 ^ word);
+            h2 = Mix(h2 + word * 0x165667B19E3779F9ULL);
+        }
+        // A zero high word marks an empty slot in FingerprintSet.
+        return IdFingerprint{Mix(h1) | 1, Mix(h2 ^ h1)};
+    }
+
+private:
+    static std::uint64_t Mix(std::uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDULL;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+};
+
+class BlockedBloomFilter {
+public:
+    explicit BlockedBloomFilter(std::size_t expectedIds) {
+        // Five blocks per 256 ids is about 12 bits per id, rounded up to a power of two for masking.
+        std::size_t wanted = std::max<std::size_t>(1, expectedIds * 5 / 256 + 1);
+        std::size_t count = 1;
+        while (count < wanted) count <<= 1;
+        blocks.assign(count, Block{});
+        mask = count - 1;
+    }
+
+    void Insert(const IdFingerprint& fingerprint) {
+        Block& block = blocks[fingerprint.high >> 32 & mask];
+        std::uint32_t key = static_cast<std::uint32_t>(fingerprint.high);
+        for (int i = 0; i < WORDS; ++i) {
+            block.words[i] |= BitFor(key, i);
+        }
+    }
+
+    bool MayContain(const IdFingerprint& fingerprint) const {
+        const Block& block = blocks[fingerprint.high >> 32 & mask];
+        std::uint32_t key = static_cast<std::uint32_t>(fingerprint.high);
+        // Accumulate instead of returning early so the loop has no data-dependent branch.
+        std::uint64_t missing = 0;
+        for (int i = 0; i < WORDS; ++i) {
+            std::uint64_t bit = BitFor(key, i);
+            missing |= ~block.words[i] & bit;
+        }
+        return missing == 0;
+    }
+
+    void Clear() {
+        std::fill(blocks.begin(), blocks.end(), Block{});
+    }
+
+private:
+    static constexpr int WORDS = 8;
+
+    struct alignas(64) Block {
+        std::array<std::uint64_t, WORDS> words{};
+    };
+
+    // Odd multipliers give each word its own bit from the same 32-bit key.
+    static std::uint64_t BitFor(std::uint32_t key, int word) {
+        static constexpr std::uint32_t SALTS[WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                       0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+        return 1ULL << ((key * SALTS[word]) >> 26);
+    }
+
+    std::vector<Block> blocks;
+    std::size_t mask;
+};
+
+class FingerprintSet {
+public:
+    explicit FingerprintSet(std::size_t initialCapacity = 64) { Rehash(SlotsFor(initialCapacity)); }
+
+    bool Contains(const IdFingerprint& fingerprint) const {
+        for (std::size_t i = fingerprint.low & mask;; i = (i + 1) & mask) {
+            if (slots[i].high == 0) return false;
+            if (slots[i] == fingerprint) return true;
+        }
+    }
+
+    // Returns false if the fingerprint was already present.
+    bool Insert(const IdFingerprint& fingerprint) {
+        if ((count + 1) * 4 > slots.size() * 3) {
+            Rehash(slots.size() * 2);
+        }
+        for (std::size_t i = fingerprint.low & mask;; i = (i + 1) & mask) {
+            if (slots[i].high == 0) {
+                slots[i] = fingerprint;
+                ++count;
+                return true;
+            }
+            if (slots[i] == fingerprint) return false;
+        }
+    }
+
+    // Keeps the table allocated for reuse by the next generation.
+    void Clear() {
+        std::fill(slots.begin(), slots.end(), IdFingerprint{0, 0});
+        count = 0;
+    }
+
+    std::size_t Size() const { return count; }
+
+private:
+    static std::size_t SlotsFor(std::size_t capacity) {
+        std::size_t slotCount = 16;
+        while (slotCount * 3 < capacity * 4) slotCount <<= 1;
+        return slotCount;
+    }
+
+    void Rehash(std::size_t slotCount) {
+        std::vector<IdFingerprint> old(slotCount, IdFingerprint{0, 0});
+        old.swap(slots);
+        mask = slotCount - 1;
+        count = 0;
+        for (const IdFingerprint& fingerprint : old) {
+            if (fingerprint.high != 0) Insert(fingerprint);
+        }
+    }
+
+    std::vector<IdFingerprint> slots;
+    std::size_t mask = 0;
+    std::size_t count = 0;
+};
+
+class TradeDeduplicator {
+public:
+    // windowNanos is measured in trade event time; capacity bounds the ids held by one generation.
+    TradeDeduplicator(long long _windowNanos = 24LL * 3600 * 1000000000LL, std::size_t _capacity = 1 << 18)
+        : windowNanos(_windowNanos), capacity(_capacity),
+          generations{Generation(_capacity), Generation(_capacity)} {
+        if (windowNanos <= 0 || capacity == 0) {
+            throw std::invalid_argument("Deduplication window and capacity must be positive");
+        }
+    }
+
+    // Ids with an event time of 0 only retire generations by capacity.
+    bool Admit(std::string_view id, long long eventTime = 0) {
+        MaybeRotate(eventTime);
+
+        IdFingerprint fingerprint = IdFingerprint::Of(id);
+        Generation& active = generations[current];
+        Generation& previous = generations[current ^ 1];
+        if ((active.bloom.MayContain(fingerprint) && active.ids.Contains(fingerprint)) ||
+            (previous.bloom.MayContain(fingerprint) && previous.ids.Contains(fingerprint))) {
+            ++duplicates;
+            return false;
+        }
+
+        active.bloom.Insert(fingerprint);
+        active.ids.Insert(fingerprint);
+        if (active.start == 0) {
+            active.start = eventTime;
+        }
+        return true;
+    }
+
+    bool Contains(std::string_view id) const {
+        IdFingerprint fingerprint = IdFingerprint::Of(id);
+        for (const Generation& generation : generations) {
+            if (generation.bloom.MayContain(fingerprint) && generation.ids.Contains(fingerprint)) return true;
+        }
+        return false;
+    }
+
+    long GetDuplicateCount() const { return duplicates; }
+    long GetRotationCount() const { return rotations; }
+    std::size_t GetSize() const { return generations[0].ids.Size() + generations[1].ids.Size(); }
+
+private:
+    struct Generation {
+        explicit Generation(std::size_t capacity) : bloom(capacity) {}
+
+        BlockedBloomFilter bloom;
+        FingerprintSet ids;
+        long long start = 0;
+    };
+
+    void MaybeRotate(long long eventTime) {
+        Generation& active = generations[current];
+        bool expired = eventTime != 0 && active.start != 0 && eventTime - active.start >= windowNanos;
+        if (!expired && active.ids.Size() < capacity) return;
+
+        Generation& oldest = generations[current ^ 1];
+        oldest.bloom.Clear();
+        oldest.ids.Clear();
+        oldest.start = 0;
+        current ^= 1;
+        ++rotations;
+    }
+
+    long long windowNanos;
+    std::size_t capacity;
+    std::array<Generation, 2> generations;
+    std::size_t current = 0;
+    long duplicates = 0;
+    long rotations = 0;
+};
+
+#endif
@@ -0,0 +1,241 @@
+// WireCodec.hpp
+//
+// Fixed-layout little-endian binary encoding of price streams and execution orders, in the style of SBE.
+//
+// @class WireHeader
+// @description The 8-byte header in front of every message: block length, template id, schema id and version,
+//              each a little-endian uint16. A reader skips a message it does not know by its block length.
+//
+// @class PriceStreamEncoder / PriceStreamDecoder
+// @description Flyweights over a caller-owned buffer. Encoding writes every field at a fixed offset and decoding
+//              reads it back from the same offset, so neither allocates nor builds an intermediate object.
+//
+// @class ExecutionOrderEncoder / ExecutionOrderDecoder
+// @description The same for execution orders.
+//
+// @format
+// - Prices are int64 mantissas with an exponent of -9, which holds every 1/256 tick exactly.
+// - Quantities and event times are int64; enums are uint8.
+// - Identifiers are fixed-length char arrays, padded with zero bytes; longer identifiers are rejected.
+// - PriceStream (template 1, block 72): productId[12] @0, eventTime @16, bidPrice @24, bidVisible @32,
+//   bidHidden @40, offerPrice @48, offerVisible @56, offerHidden @64.
+// - ExecutionOrder (template 2, block 96): productId[12] @0, side @12, orderType @13, market @14, isChild @15,
+//   eventTime @16, price @24, visible @32, hidden @40, orderId[24] @48, parentOrderId[24] @72.
+//
+// @methods (encoders)
+// - Wrap: Points the encoder at a buffer and writes the header; throws if the message does not fit.
+// - Encode: Writes all fields of one object; returns the encoded length including the header.
+//
+// @methods (decoders)
+// - Wrap: Points the decoder at a message; throws if the header does not match the template.
+// - Field accessors: Read one field; identifiers are returned as views into the buffer.
+
+#ifndef WIRECODEC_HPP
+#define WIRECODEC_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "PriceStream.hpp"
+#include "ExecutionOrder.hpp"
+
+enum WireFormat { TEXT_FORMAT, BINARY_FORMAT };
+
+namespace Wire {
+
+constexpr std::uint16_t SCHEMA_ID = 9815;
+constexpr std::uint16_t SCHEMA_VERSION = 1;
+constexpr std::size_t HEADER_LENGTH = 8;
+constexpr double PRICE_SCALE = 1e9;
+
+template<typename V>
+V ByteSwap(V value) {
+    unsigned char bytes[sizeof(V)];
+    std::memcpy(bytes, &value, sizeof(V));
+    for (std::size_t i = 0; i < sizeof(V) / 2; ++i) {
+        std::swap(bytes[i], bytes[sizeof(V) - 1 - i]);
+    }
+    std::memcpy(&value, bytes, sizeof(V));
+    return value;
+}
+
+// On little-endian hosts these compile to a single unaligned load or store.
+template<typename V>
+void Put(char* buffer, std::size_t offset, V value) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = ByteSwap(value);
+#endif
+    std::memcpy(buffer + offset, &value, sizeof(V));
+}
+
+template<typename V>
+V Get(const char* buffer, std::size_t offset) {
+    V value;
+    std::memcpy(&value, buffer + offset, sizeof(V));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = ByteSwap(value);
+#endif
+    return value;
+}
+
+inline void PutChars(char* buffer, std::size_t offset, std::size_t length, std::string_view value) {
+    if (value.size() > length) {
+        throw std::length_error("Identifier does not fit its wire field: " + std::string(value));
+    }
+    std::memcpy(buffer + offset, value.data(), value.size());
+    std::memset(buffer + offset + value.size(), 0, length - value.size());
+}
+
+inline std::string_view GetChars(const char* buffer, std::size_t offset, std::size_t length) {
+    const char* start = buffer + offset;
+    const void* end = std::memchr(start, 0, length);
+    return std::string_view(start, end != nullptr ? static_cast<const char*>(end) - start : length);
+}
+
+inline std::int64_t PriceToMantissa(double price) { return std::llround(price * PRICE_SCALE); }
+inline double MantissaToPrice(std::int64_t mantissa) { return static_cast<double>(mantissa) / PRICE_SCALE; }
+
+}  // namespace Wire
+
+class WireHeader {
+public:
+    static void Write(char* buffer, std::uint16_t blockLength, std::uint16_t templateId) {
+        Wire::Put<std::uint16_t>(buffer, 0, blockLength);
+        Wire::Put<std::uint16_t>(buffer, 2, templateId);
+        Wire::Put<std::uint16_t>(buffer, 4, Wire::SCHEMA_ID);
+        Wire::Put<std::uint16_t>(buffer, 6, Wire::SCHEMA_VERSION);
+    }
+
+    static std::uint16_t BlockLength(const char* buffer) { return Wire::Get<std::uint16_t>(buffer, 0); }
+    static std::uint16_t TemplateId(const char* buffer) { return Wire::Get<std::uint16_t>(buffer, 2); }
+    static std::uint16_t SchemaId(const char* buffer) { return Wire::Get<std::uint16_t>(buffer, 4); }
+    static std::uint16_t Version(const char* buffer) { return Wire::Get<std::uint16_t>(buffer, 6); }
+
+    // Returns the body of a message after checking its header, or throws.
+    static const char* Check(const char* buffer, std::size_t length, std::uint16_t templateId, std::uint16_t blockLength) {
+        if (length < Wire::HEADER_LENGTH + blockLength || SchemaId(buffer) != Wire::SCHEMA_ID
+            || TemplateId(buffer) != templateId || BlockLength(buffer) < blockLength) {
+            throw std::invalid_argument("Wire message does not match template " + std::to_string(templateId));
+        }
+        return buffer + Wire::HEADER_LENGTH;
+    }
+};
+
+class PriceStreamEncoder {
+public:
+    static constexpr std::uint16_t TEMPLATE_ID = 1;
+    static constexpr std::uint16_t BLOCK_LENGTH = 72;
+    static constexpr std::size_t ENCODED_LENGTH = Wire::HEADER_LENGTH + BLOCK_LENGTH;
+
+    PriceStreamEncoder& Wrap(char* buffer, std::size_t capacity) {
+        if (capacity < ENCODED_LENGTH) {
+            throw std::length_error("Buffer too small for a price stream message");
+        }
+        WireHeader::Write(buffer, BLOCK_LENGTH, TEMPLATE_ID);
+        body = buffer + Wire::HEADER_LENGTH;
+        return *this;
+    }
+
+    template<typename T>
+    std::size_t Encode(const PriceStream<T>& priceStream) {
+        const PriceStreamOrder& bid = priceStream.GetBidOrder();
+        const PriceStreamOrder& offer = priceStream.GetOfferOrder();
+        Wire::PutChars(body, 0, 12, priceStream.GetProduct().GetProductId());
+        std::memset(body + 12, 0, 4);
+        Wire::Put<std::int64_t>(body, 16, priceStream.GetEventTime());
+        Wire::Put<std::int64_t>(body, 24, Wire::PriceToMantissa(bid.GetPrice()));
+        Wire::Put<std::int64_t>(body, 32, bid.GetVisibleQuantity());
+        Wire::Put<std::int64_t>(body, 40, bid.GetHiddenQuantity());
+        Wire::Put<std::int64_t>(body, 48, Wire::PriceToMantissa(offer.GetPrice()));
+        Wire::Put<std::int64_t>(body, 56, offer.GetVisibleQuantity());
+        Wire::Put<std::int64_t>(body, 64, offer.GetHiddenQuantity());
+        return ENCODED_LENGTH;
+    }
+
+private:
+    char* body = nullptr;
+};
+
+class PriceStreamDecoder {
+public:
+    PriceStreamDecoder& Wrap(const char* buffer, std::size_t length) {
+        body = WireHeader::Check(buffer, length, PriceStreamEncoder::TEMPLATE_ID, PriceStreamEncoder::BLOCK_LENGTH);
+        return *this;
+    }
+
+    std::string_view ProductId() const { return Wire::GetChars(body, 0, 12); }
+    long long EventTime() const { return Wire::Get<std::int64_t>(body, 16); }
+    double BidPrice() const { return Wire::MantissaToPrice(Wire::Get<std::int64_t>(body, 24)); }
+    long BidVisibleQuantity() const { return Wire::Get<std::int64_t>(body, 32); }
+    long BidHiddenQuantity() const { return Wire::Get<std::int64_t>(body, 40); }
+    double OfferPrice() const { return Wire::MantissaToPrice(Wire::Get<std::int64_t>(body, 48)); }
+    long OfferVisibleQuantity() const { return Wire::Get<std::int64_t>(body, 56); }
+    long OfferHiddenQuantity() const { return Wire::Get<std::int64_t>(body, 64); }
+
+private:
+    const char* body = nullptr;
+};
+
+class ExecutionOrderEncoder {
+public:
+    static constexpr std::uint16_t TEMPLATE_ID = 2;
+    static constexpr std::uint16_t BLOCK_LENGTH = 96;
+    static constexpr std::size_t ENCODED_LENGTH = Wire::HEADER_LENGTH + BLOCK_LENGTH;
+
+    ExecutionOrderEncoder& Wrap(char* buffer, std::size_t capacity) {
+        if (capacity < ENCODED_LENGTH) {
+            throw std::length_error("Buffer too small for an execution order message");
+        }
+        WireHeader::Write(buffer, BLOCK_LENGTH, TEMPLATE_ID);
+        body = buffer + Wire::HEADER_LENGTH;
+        return *this;
+    }
+
+    template<typename T>
+    std::size_t Encode(const ExecutionOrder<T>& order, Market market) {
+        Wire::PutChars(body, 0, 12, order.GetProduct().GetProductId());
+        Wire::Put<std::uint8_t>(body, 12, static_cast<std::uint8_t>(order.GetSide()));
+        Wire::Put<std::uint8_t>(body, 13, static_cast<std::uint8_t>(order.GetOrderType()));
+        Wire::Put<std::uint8_t>(body, 14, static_cast<std::uint8_t>(market));
+        Wire::Put<std::uint8_t>(body, 15, order.IsChildOrder() ? 1 : 0);
+        Wire::Put<std::int64_t>(body, 16, order.GetEventTime());
+        Wire::Put<std::int64_t>(body, 24, Wire::PriceToMantissa(order.GetPrice()));
+        Wire::Put<std::int64_t>(body, 32, order.GetVisibleQuantity());
+        Wire::Put<std::int64_t>(body, 40, order.GetHiddenQuantity());
+        Wire::PutChars(body, 48, 24, order.GetOrderId());
+        Wire::PutChars(body, 72, 24, order.GetParentOrderId());
+        return ENCODED_LENGTH;
+    }
+
+private:
+    char* body = nullptr;
+};
+
+class ExecutionOrderDecoder {
+public:
+    ExecutionOrderDecoder& Wrap(const char* buffer, std::size_t length) {
+        body = WireHeader::Check(buffer, length, ExecutionOrderEncoder::TEMPLATE_ID, ExecutionOrderEncoder::BLOCK_LENGTH);
+        return *this;
+    }
+
+    std::string_view ProductId() const { return Wire::GetChars(body, 0, 12); }
+    PricingSide Side() const { return static_cast<PricingSide>(Wire::Get<std::uint8_t>(body, 12)); }
+    OrderType Type() const { return static_cast<OrderType>(Wire::Get<std::uint8_t>(body, 13)); }
+    Market Venue() const { return static_cast<Market>(Wire::Get<std::uint8_t>(body, 14)); }
+    bool IsChildOrder() const { return Wire::Get<std::uint8_t>(body, 15) != 0; }
+    long long EventTime() const { return Wire::Get<std::int64_t>(body, 16); }
+    double Price() const { return Wire::MantissaToPrice(Wire::Get<std::int64_t>(body, 24)); }
+    long VisibleQuantity() const { return Wire::Get<std::int64_t>(body, 32); }
+    long HiddenQuantity() const { return Wire::Get<std::int64_t>(body, 40); }
+    std::string_view OrderId() const { return Wire::GetChars(body, 48, 24); }
+    std::string_view ParentOrderId() const { return Wire::GetChars(body, 72, 24); }
+
+private:
+    const char* body = nullptr;
+};
+
+#endif
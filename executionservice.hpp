@@ -4,7 +4,16 @@
 //
 // @class ExecutionService
 // @description Manages the execution of orders, integrates with connectors, and supports listeners for market execution updates.
-//              The service operates on execution orders tied to specific products.
+//              The service operates on execution orders tied to specific products. An attached OrderThrottle
+//              limits the order rate per venue and per product. Orders are stored, passed to listeners and
+//              published only when they are actually sent, so throttled orders that are rejected, conflated
+//              away or still queued are never booked. Orders the throttle drops are passed to listeners as
+//              ProcessRemove.
+//
+// @class ExecutionServiceConnector
+// @description Publishes execution orders to a market, as text or in the binary wire encoding of WireCodec.hpp,
+//              to the stream given to SetOutput. It writes nothing until a stream is set. With a FIX sender
+//              attached, orders for the venues it knows go out as FIX NewOrderSingle messages instead.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -15,7 +24,9 @@
 #ifndef EXECUTION_SERVICE_HPP
 #define EXECUTION_SERVICE_HPP
 
+#include <memory>
 #include <string>
+#include <string_view>
 #include <map>
 #include <vector>
 #include <iostream>
@@ -23,6 +34,11 @@
 #include "soa.hpp"
 #include "ExecutionOrder.hpp"
 #include "AlgoExecution.hpp"
+#include "TraceRecorder.hpp"
+#include "WireCodec.hpp"
+#include "FixOrderEncoder.hpp"
+#include "OrderThrottle.hpp"
+#include "TimerWheel.hpp"
 
 /**
  * Forward declaration of ExecutionServiceConnector and ExecutionServiceListener.
@@ -41,9 +57,10 @@ template <typename T>
 class ExecutionService : public Service<std::string, ExecutionOrder<T>> {
 public:
     ExecutionService();
-    ~ExecutionService() = default;
+    ~ExecutionService();
 
     ExecutionOrder<T> &GetData(std::string key) override;
+    ExecutionOrder<T> *TryGet(std::string_view key) override;
     void OnMessage(ExecutionOrder<T> &data) override;
     void AddListener(ServiceListener<ExecutionOrder<T>> *listener) override;
     const std::vector<ServiceListener<ExecutionOrder<T>> *> &GetListeners() const override;
@@ -54,23 +71,51 @@ public:
     void ExecuteOrder(const ExecutionOrder<T> &order, Market market);
     void AddExecutionOrder(const AlgoExecution<T> &algoExecution);
 
+    // Pending orders are released every drainNanos on the timer wheel, and whenever a new order arrives.
+    void AttachThrottle(std::unique_ptr<OrderThrottle<T>> _throttle, TimerWheel *timers = nullptr, long long drainNanos = 0);
+    OrderThrottle<T> *GetThrottle() { return throttle.get(); }
+    void DrainThrottle();
+    size_t DiscardPendingOrders();
+
 private:
-    std::map<std::string, ExecutionOrder<T>> executionOrderData;
+    void Send(const ExecutionOrder<T> &order, Market market);
+    void Drop(const ExecutionOrder<T> &order);
+
+    std::map<std::string, ExecutionOrder<T>, std::less<>> executionOrderData;
     std::vector<ServiceListener<ExecutionOrder<T>> *> listeners;
     ExecutionServiceConnector<T> *connector;
     ExecutionServiceListener<T> *executionServiceListener;
+    std::unique_ptr<OrderThrottle<T>> throttle;
+    TimerWheel *drainTimers = nullptr;
+    TimerId drainTimer = INVALID_TIMER;
 };
 
 template <typename T>
-ExecutionService<T>::ExecutionService() : executionServiceListener(new ExecutionServiceListener<T>(this)), connector(nullptr) {}
+ExecutionService<T>::ExecutionService()
+    : connector(new ExecutionServiceConnector<T>(this)), executionServiceListener(new ExecutionServiceListener<T>(this)) {}
+
+template <typename T>
+ExecutionService<T>::~ExecutionService() {
+    if (drainTimers != nullptr) {
+        drainTimers->Cancel(drainTimer);
+    }
+    delete connector;
+    delete executionServiceListener;
+}
 
 template <typename T>
 ExecutionOrder<T> &ExecutionService<T>::GetData(std::string key) {
-    auto it = executionOrderData.find(key);
-    if (it != executionOrderData.end()) {
-        return it->second;
+    ExecutionOrder<T> *order = TryGet(key);
+    if (order == nullptr) {
+        throw std::runtime_error("Specified key not found");
     }
-    throw std::runtime_error("Specified key not found");
+    return *order;
+}
+
+template <typename T>
+ExecutionOrder<T> *ExecutionService<T>::TryGet(std::string_view key) {
+    auto it = executionOrderData.find(key);
+    return it != executionOrderData.end() ? &it->second : nullptr;
 }
 
 template <typename T>
@@ -100,27 +145,68 @@ ExecutionServiceConnector<T> *ExecutionService<T>::GetConnector() {
 
 template <typename T>
 void ExecutionService<T>::ExecuteOrder(const ExecutionOrder<T> &order, Market market) {
+    TRACE_SPAN("ExecutionService::ExecuteOrder");
+    if (throttle) {
+        throttle->Submit(order, market, [this](const ExecutionOrder<T> &admitted, Market venue) { Send(admitted, venue); });
+        return;
+    }
+    Send(order, market);
+}
+
+template <typename T>
+void ExecutionService<T>::Send(const ExecutionOrder<T> &order, Market market) {
+    ExecutionOrder<T> &sent = executionOrderData.insert_or_assign(order.GetOrderId(), order).first->second;
+    for (auto &listener : listeners) {
+        listener->ProcessAdd(sent);
+    }
     if (connector) {
         connector->Publish(order, market);
     }
 }
 
 template <typename T>
-void ExecutionService<T>::AddExecutionOrder(const AlgoExecution<T> &algoExecution) {
-    ExecutionOrder<T> executionOrder = algoExecution.GetExecutionOrder();
-    std::string orderId = executionOrder.GetOrderId();
+void ExecutionService<T>::Drop(const ExecutionOrder<T> &order) {
+    ExecutionOrder<T> dropped = order;
+    for (auto &listener : listeners) {
+        listener->ProcessRemove(dropped);
+    }
+}
 
-    if (executionOrderData.find(orderId) != executionOrderData.end())
-    {
-        executionOrderData.erase(orderId);
+template <typename T>
+void ExecutionService<T>::AttachThrottle(std::unique_ptr<OrderThrottle<T>> _throttle, TimerWheel *timers, long long drainNanos) {
+    DrainThrottle();
+    if (drainTimers != nullptr) {
+        drainTimers->Cancel(drainTimer);
+        drainTimers = nullptr;
+    }
+    throttle = std::move(_throttle);
+    if (throttle) {
+        throttle->SetDropHandler([this](const ExecutionOrder<T> &dropped) { Drop(dropped); });
     }
-    executionOrderData.insert(std::make_pair(orderId, executionOrder));
+    if (throttle && timers != nullptr && drainNanos > 0) {
+        drainTimers = timers;
+        drainTimer = timers->SchedulePeriodic(drainNanos, [this]() { DrainThrottle(); });
+    }
+}
 
-    for (auto &listener : listeners) {
-        listener->ProcessAdd(executionOrder);
+template <typename T>
+void ExecutionService<T>::DrainThrottle() {
+    if (throttle) {
+        throttle->Drain([this](const ExecutionOrder<T> &admitted, Market venue) { Send(admitted, venue); });
     }
 }
 
+template <typename T>
+size_t ExecutionService<T>::DiscardPendingOrders() {
+    return throttle ? throttle->DiscardPending() : 0;
+}
+
+template <typename T>
+void ExecutionService<T>::AddExecutionOrder(const AlgoExecution<T> &algoExecution) {
+    TRACE_SPAN("ExecutionService::AddExecutionOrder");
+    ExecuteOrder(algoExecution.GetExecutionOrder(), algoExecution.GetMarket());
+}
+
 /**
  * ExecutionServiceConnector class
  * Publishes ExecutionOrder data to markets.
@@ -131,17 +217,44 @@ public:
     explicit ExecutionServiceConnector(ExecutionService<T> *_service);
     ~ExecutionServiceConnector() = default;
 
+    void Publish(ExecutionOrder<T> &order) override { Market market = BROKERTEC; Publish(order, market); }
     void Publish(const ExecutionOrder<T> &order, Market &market);
+    // A null stream turns the output off again.
+    void SetOutput(WireFormat _format, std::ostream *_output);
+    void AttachFixSender(FixOrderSender *_fixSender) { fixSender = _fixSender; }
 
 private:
     ExecutionService<T> *service;
+    FixOrderSender *fixSender = nullptr;
+    WireFormat format = TEXT_FORMAT;
+    std::ostream *output = nullptr;
+    ExecutionOrderEncoder encoder;
+    char buffer[ExecutionOrderEncoder::ENCODED_LENGTH];
 };
 
 template <typename T>
 ExecutionServiceConnector<T>::ExecutionServiceConnector(ExecutionService<T> *_service) : service(_service) {}
 
+template <typename T>
+void ExecutionServiceConnector<T>::SetOutput(WireFormat _format, std::ostream *_output) {
+    format = _format;
+    output = _output;
+}
+
 template <typename T>
 void ExecutionServiceConnector<T>::Publish(const ExecutionOrder<T> &order, Market &market) {
+    if (fixSender != nullptr && fixSender->Send(order, market)) {
+        return;
+    }
+    if (output == nullptr) {
+        return;
+    }
+    if (format == BINARY_FORMAT) {
+        std::size_t length = encoder.Wrap(buffer, sizeof(buffer)).Encode(order, market);
+        output->write(buffer, static_cast<std::streamsize>(length));
+        return;
+    }
+
     std::string orderType;
     switch (order.GetOrderType()) {
         case FOK: orderType = "FOK"; break;
@@ -158,7 +271,7 @@ void ExecutionServiceConnector<T>::Publish(const ExecutionOrder<T> &order, Marke
         case CME: tradeMarket = "CME"; break;
     }
 
-    std::cout << "ExecutionOrder: \n"
+    *output << "ExecutionOrder: \n"
               << "\tProduct: " << order.GetProduct().GetProductId() << "\tOrderId: " << order.GetOrderId() << "\tMarket: " << tradeMarket << "\n"
               << "\tPricingSide: " << (order.GetSide() == BID ? "Bid" : "Offer")
               << "\tOrderType: " << orderType << "\tChildOrder: " << (order.IsChildOrder() ? "Yes" : "No") << "\n"
@@ -189,7 +302,6 @@ ExecutionServiceListener<T>::ExecutionServiceListener(ExecutionService<T> *_exec
 template <typename T>
 void ExecutionServiceListener<T>::ProcessAdd(AlgoExecution<T> &data) {
     executionService->AddExecutionOrder(data);
-    executionService->ExecuteOrder(data.GetExecutionOrder(), data.GetMarket());
 }
 
 template <typename T>
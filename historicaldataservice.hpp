@@ -6,6 +6,13 @@
 // @class HistoricalDataService
 // @description Manages persistence of data across various service types including Position, Risk, Execution,
 //              Streaming, and Inquiry. Supports data addition, listener notification, and external publishing.
+//              Output goes to a per-type file under a configurable directory, which is opened once by the
+//              connector and kept open for the lifetime of the service. Records are flushed one by one unless a
+//              periodic flush is scheduled on a timer wheel. Each record is stamped with the service's clock,
+//              followed by the event time the record carries from its source message (empty when unknown).
+//              With a compacted log enabled, records go instead to a segmented log under "<directory>/compacted",
+//              keyed like the cache, whose older segments are compacted to the latest record per key in the
+//              background; the latest persisted state of a key is then one seek away.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -23,11 +30,18 @@
 #include "inquiryservice.hpp"
 #include "positionservice.hpp"
 #include "TimeUtils.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
+#include "Clocks.hpp"
+#include "CompactedLog.hpp"
 #include <fstream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <string_view>
 
 // Enumeration identifying the category of service data to be persisted.
 enum ServiceType {POSITION, RISK, EXECUTION, STREAMING, INQUIRY};
@@ -49,43 +63,75 @@ template<typename T>
 class HistoricalDataService : public Service<std::string, T>
 {
 public:
-    HistoricalDataService(ServiceType _type);
-    ~HistoricalDataService() = default;
+    HistoricalDataService(ServiceType _type, std::string _outputDirectory = "./result",
+                          const IClock& _clock = RealTimeClock::Instance());
+    ~HistoricalDataService();
 
     T& GetData(std::string key) override;
+    T* TryGet(std::string_view key) override;
     void OnMessage(T& data) override;
     void AddListener(ServiceListener<T>* listener) override;
     const std::vector<ServiceListener<T>*>& GetListeners() const override;
     HistoricalDataServiceListener<T>* GetHistoricalDataServiceListener();
     HistoricalDataConnector<T>* GetConnector();
     ServiceType GetServiceType() const;
+    const std::string& GetOutputDirectory() const;
+    const IClock& GetClock() const;
     void PersistData(std::string persistKey, T& data);
+    void EnablePeriodicFlush(TimerWheel& timers, long long intervalNanos);
+    void EnableCompactedLog(std::uint64_t segmentBytes, size_t historySegments = 1);
+    CompactedLog* GetCompactedLog();
 
 private:
-    std::map<std::string, T> hisData;                 // Internal container for persistent data
+    std::map<std::string, T, std::less<>> hisData;    // Internal container for persistent data
     std::vector<ServiceListener<T>*> listeners;       // Registered listeners
     HistoricalDataConnector<T>* connector;            // Connector for external storage
     ServiceType type;                                 // Type of data managed by this service
+    std::string outputDirectory;                      // Directory holding the persisted file
+    const IClock& clock;                              // Clock stamping each persisted record
     HistoricalDataServiceListener<T>* historicalservicelistener; // Associated listener
+    TimerWheel* flushTimers = nullptr;                // Wheel running the periodic flush, if any
+    TimerId flushTimer = INVALID_TIMER;               // Periodic flush timer
 };
 
 template<typename T>
-HistoricalDataService<T>::HistoricalDataService(ServiceType _type)
+HistoricalDataService<T>::HistoricalDataService(ServiceType _type, std::string _outputDirectory, const IClock& _clock)
     : type(_type),
-      historicalservicelistener(new HistoricalDataServiceListener<T>(this)),
-      connector(new HistoricalDataConnector<T>(this))
+      outputDirectory(std::move(_outputDirectory)),
+      clock(_clock),
+      historicalservicelistener(new HistoricalDataServiceListener<T>(this))
 {
+    // The connector reads the type and directory, so it is created after all members are set.
+    connector = new HistoricalDataConnector<T>(this);
+}
+
+template<typename T>
+HistoricalDataService<T>::~HistoricalDataService()
+{
+    if (flushTimers != nullptr)
+    {
+        flushTimers->Cancel(flushTimer);
+    }
+    delete connector;
+    delete historicalservicelistener;
 }
 
 template<typename T>
 T& HistoricalDataService<T>::GetData(std::string key)
 {
-    auto it = hisData.find(key);
-    if (it != hisData.end())
+    T* data = TryGet(key);
+    if (data == nullptr)
     {
-        return it->second;
+        throw std::runtime_error("Key not found");
     }
-    throw std::runtime_error("Key not found");
+    return *data;
+}
+
+template<typename T>
+T* HistoricalDataService<T>::TryGet(std::string_view key)
+{
+    auto it = hisData.find(key);
+    return it != hisData.end() ? &it->second : nullptr;
 }
 
 template<typename T>
@@ -124,14 +170,48 @@ ServiceType HistoricalDataService<T>::GetServiceType() const
     return type;
 }
 
+template<typename T>
+const std::string& HistoricalDataService<T>::GetOutputDirectory() const
+{
+    return outputDirectory;
+}
+
+template<typename T>
+const IClock& HistoricalDataService<T>::GetClock() const
+{
+    return clock;
+}
+
 template<typename T>
 void HistoricalDataService<T>::PersistData(std::string persistKey, T& data)
 {
-    if (hisData.find(persistKey) == hisData.end())
-        hisData.insert(std::make_pair(persistKey, data));
-    else
-        hisData[persistKey] = data;
-    connector->Publish(data);
+    TRACE_SPAN("HistoricalDataService::PersistData");
+    connector->Publish(persistKey, data);
+    hisData.insert_or_assign(std::move(persistKey), data);
+}
+
+template<typename T>
+void HistoricalDataService<T>::EnablePeriodicFlush(TimerWheel& timers, long long intervalNanos)
+{
+    if (flushTimers != nullptr)
+    {
+        flushTimers->Cancel(flushTimer);
+    }
+    flushTimers = &timers;
+    connector->SetFlushEachRecord(false);
+    flushTimer = timers.SchedulePeriodic(intervalNanos, [this]() { connector->Flush(); });
+}
+
+template<typename T>
+void HistoricalDataService<T>::EnableCompactedLog(std::uint64_t segmentBytes, size_t historySegments)
+{
+    connector->EnableCompactedLog(segmentBytes, historySegments);
+}
+
+template<typename T>
+CompactedLog* HistoricalDataService<T>::GetCompactedLog()
+{
+    return connector->GetCompactedLog();
 }
 
 /**
@@ -144,38 +224,104 @@ class HistoricalDataConnector : public Connector<T>
 public:
     explicit HistoricalDataConnector(HistoricalDataService<T>* _service);
     void Publish(T& data) override;
+    void Publish(const std::string& key, T& data);
+    void Flush();
+    void SetFlushEachRecord(bool _flushEachRecord);
+    void EnableCompactedLog(std::uint64_t segmentBytes, size_t historySegments);
+    CompactedLog* GetCompactedLog();
 
 private:
+    static std::string FileName(ServiceType type);
+    void WriteRecord(std::ostream& out, T& data);
+
     HistoricalDataService<T>* service;
+    std::ofstream outFile;
+    bool flushEachRecord = true;
+    std::unique_ptr<CompactedLog> log;      // Replaces the flat file when enabled
+    std::ostringstream record;              // Reused to format records for the log
 };
 
 template<typename T>
 HistoricalDataConnector<T>::HistoricalDataConnector(HistoricalDataService<T>* _service)
     : service(_service)
 {
+    // Opening up front creates the file before the first record instead of on every publish.
+    outFile.open(service->GetOutputDirectory() + "/" + FileName(service->GetServiceType()), std::ios::app);
 }
 
 template<typename T>
-void HistoricalDataConnector<T>::Publish(T& data)
+std::string HistoricalDataConnector<T>::FileName(ServiceType type)
 {
-    std::ofstream outFile;
-    std::string fileName;
-
-    switch (service->GetServiceType())
+    switch (type)
     {
-        case POSITION: fileName = "./result/positions.txt"; break;
-        case RISK: fileName = "./result/risk.txt"; break;
-        case EXECUTION: fileName = "./result/executions.txt"; break;
-        case STREAMING: fileName = "./result/streaming.txt"; break;
-        case INQUIRY: fileName = "./result/allinquiries.txt"; break;
+        case POSITION: return "positions.txt";
+        case RISK: return "risk.txt";
+        case EXECUTION: return "executions.txt";
+        case STREAMING: return "streaming.txt";
+        case INQUIRY: return "allinquiries.txt";
     }
+    return "unknown.txt";
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::WriteRecord(std::ostream& out, T& data)
+{
+    long long eventTime = data.GetEventTime();
+    out << service->GetClock().NowString() << ","
+        << (eventTime != 0 ? TimeUtils::FormatNanos(eventTime) : std::string()) << "," << data;
+}
 
-    outFile.open(fileName, std::ios::app);
+template<typename T>
+void HistoricalDataConnector<T>::Publish(T& data)
+{
     if (outFile.is_open())
     {
-        outFile << TimeUtils::GetCurrentTime() << "," << data << std::endl;
+        WriteRecord(outFile, data);
+        outFile << '\n';
+        if (flushEachRecord)
+        {
+            outFile.flush();
+        }
+    }
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::Publish(const std::string& key, T& data)
+{
+    if (!log)
+    {
+        Publish(data);
+        return;
     }
-    outFile.close();
+    record.str(std::string());
+    WriteRecord(record, data);
+    log->Append(key, record.str());
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::EnableCompactedLog(std::uint64_t segmentBytes, size_t historySegments)
+{
+    std::string name = FileName(service->GetServiceType());
+    name.erase(name.rfind('.'));
+    log = std::make_unique<CompactedLog>(service->GetOutputDirectory() + "/compacted", name, segmentBytes, historySegments);
+}
+
+template<typename T>
+CompactedLog* HistoricalDataConnector<T>::GetCompactedLog()
+{
+    return log.get();
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::Flush()
+{
+    outFile.flush();
+}
+
+template<typename T>
+void HistoricalDataConnector<T>::SetFlushEachRecord(bool _flushEachRecord)
+{
+    flushEachRecord = _flushEachRecord;
 }
 
 /**
@@ -230,7 +376,8 @@ void HistoricalDataServiceListener<T>::ProcessRemove(T& data)
 template<typename T>
 void HistoricalDataServiceListener<T>::ProcessUpdate(T& data)
 {
-    // No update logic implemented
+    // Corrections are persisted like any other change to the record.
+    ProcessAdd(data);
 }
 
 #endif
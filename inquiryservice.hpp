@@ -18,27 +18,39 @@
 // - GetQuantity: Returns the inquiry quantity.
 // - GetPrice: Returns the inquiry price.
 // - GetState: Returns the current state of the inquiry.
+// - GetEventTime: Returns the time the client sent the inquiry in nanoseconds since the epoch, or 0 when unknown.
+// - GetClient: Returns the client that sent the inquiry, or an empty string when unknown.
 // - SetPrice: Sets the price of the inquiry.
 // - SetState: Updates the inquiry's state.
 //
 // @methods (InquiryService)
 // - GetData: Retrieves an inquiry by its ID.
-// - OnMessage: Handles updates to inquiries, managing state transitions and broadcasting changes.
+// - TryGet: Retrieves an inquiry by its ID, or nullptr if none exists.
+// - OnMessage: Handles updates to inquiries, managing state transitions and broadcasting changes. Listeners see
+//   each state once and in order: RECEIVED, QUOTED, then DONE (or REJECTED).
 // - AddListener: Adds a listener to the service.
 // - GetListeners: Retrieves all registered listeners.
 // - GetConnector: Returns the associated connector.
 // - SendQuote: Sends a price quote for an inquiry.
 // - RejectInquiry: Marks an inquiry as rejected.
+// - Reserve: Pre-sizes the inquiry store for the expected number of open inquiries.
+// - EnableTimeouts: Rejects inquiries still RECEIVED or QUOTED after a timeout, using a timer wheel.
+// - AttachQuoter: Quotes received inquiries from the market through an InquiryQuoter instead of their own price.
 //
 // @methods (InquiryConnector)
 // - Publish: Publishes an inquiry, updating its state as necessary.
-// - Subscribe: Reads and processes inquiries from an input file.
+// - Subscribe: Reads and processes inquiries from an input file. An optional seventh column holds the event time
+//   and an optional eighth the client.
 // - SubscribeUpdate: Subscribes to updates for an inquiry.
+// - AttachTimerWheel: Drives a timer wheel from the inquiry feed.
+// - AttachEventClock: Advances an event-time clock to the timestamp of each inquiry.
 //
 // @attributes
 // - inquiryData: Stores inquiries keyed by their unique identifiers.
 // - listeners: A vector of listeners for the service.
 // - connector: Handles data flow for the service.
+// - timeouts: Pending timeout timers of open inquiries, keyed by inquiry id.
+// - quoter: Market quoter of received inquiries, or nullptr.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -52,6 +64,10 @@
 
 #include "soa.hpp"
 #include "tradebookingservice.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
+#include "TimeUtils.hpp"
+#include "InquiryQuoter.hpp"
 #include <fstream>
 #include <sstream>
 #include <vector>
@@ -69,7 +85,8 @@ class Inquiry
 {
 public:
     Inquiry() = default;
-    Inquiry(std::string _inquiryId, const T& _product, Side _side, long _quantity, double _price, InquiryState _state);
+    Inquiry(std::string _inquiryId, const T& _product, Side _side, long _quantity, double _price, InquiryState _state,
+            long long _eventTime = 0, std::string _client = "");
     ~Inquiry() = default;
 
     const std::string& GetInquiryId() const;
@@ -78,6 +95,8 @@ public:
     long GetQuantity() const;
     double GetPrice() const;
     InquiryState GetState() const;
+    long long GetEventTime() const;
+    const std::string& GetClient() const;
 
     void SetPrice(double _price);
     void SetState(InquiryState state);
@@ -92,11 +111,15 @@ private:
     long quantity;
     double price;
     InquiryState state;
+    long long eventTime = 0;
+    std::string client;
 };
 
 template<typename T>
-Inquiry<T>::Inquiry(std::string _inquiryId, const T& _product, Side _side, long _quantity, double _price, InquiryState _state)
-    : inquiryId(_inquiryId), product(_product), side(_side), quantity(_quantity), price(_price), state(_state)
+Inquiry<T>::Inquiry(std::string _inquiryId, const T& _product, Side _side, long _quantity, double _price, InquiryState _state,
+                    long long _eventTime, std::string _client)
+    : inquiryId(_inquiryId), product(_product), side(_side), quantity(_quantity), price(_price), state(_state),
+      eventTime(_eventTime), client(std::move(_client))
 {
 }
 
@@ -118,6 +141,12 @@ double Inquiry<T>::GetPrice() const { return price; }
 template<typename T>
 InquiryState Inquiry<T>::GetState() const { return state; }
 
+template<typename T>
+long long Inquiry<T>::GetEventTime() const { return eventTime; }
+
+template<typename T>
+const std::string& Inquiry<T>::GetClient() const { return client; }
+
 template<typename T>
 void Inquiry<T>::SetPrice(double _price) { price = _price; }
 
@@ -160,12 +189,20 @@ private:
     InquiryConnector<T>* connector;
     std::unordered_map<std::string, Inquiry<T>> inquiryData;
     std::vector<ServiceListener<Inquiry<T>>*> listeners;
+    TimerWheel* timers = nullptr;
+    long long timeoutNanos = 0;
+    std::unordered_map<std::string, TimerId> timeouts;
+    InquiryQuoter<T>* quoter = nullptr;
+
+    void UpdateTimeout(const Inquiry<T>& data);
+    void Record(Inquiry<T>& data);
 
 public:
     InquiryService();
-    ~InquiryService() = default;
+    ~InquiryService();
 
     Inquiry<T>& GetData(std::string key) override;
+    Inquiry<T>* TryGet(std::string_view key) override;
     void OnMessage(Inquiry<T>& data) override;
     void AddListener(ServiceListener<Inquiry<T>>* listener) override;
     const std::vector<ServiceListener<Inquiry<T>>*>& GetListeners() const override;
@@ -173,50 +210,78 @@ public:
 
     void SendQuote(const std::string& inquiryId, double price);
     void RejectInquiry(const std::string& inquiryId);
+    void Reserve(size_t inquiryCount);
+    void EnableTimeouts(TimerWheel& _timers, long long _timeoutNanos);
+    void AttachQuoter(InquiryQuoter<T>* _quoter) { quoter = _quoter; }
 };
 
 template<typename T>
 InquiryService<T>::InquiryService() : connector(new InquiryConnector<T>(this)) {}
 
+template<typename T>
+InquiryService<T>::~InquiryService()
+{
+    if (timers != nullptr)
+    {
+        for (const auto& [inquiryId, timer] : timeouts)
+        {
+            timers->Cancel(timer);
+        }
+    }
+}
+
 template<typename T>
 Inquiry<T>& InquiryService<T>::GetData(std::string key)
 {
-    auto it = inquiryData.find(key);
-    if (it != inquiryData.end())
+    Inquiry<T>* inquiry = TryGet(key);
+    if (inquiry == nullptr)
     {
-        return it->second;
+        throw std::runtime_error("Key not found");
     }
-    throw std::runtime_error("Key not found");
+    return *inquiry;
+}
+
+template<typename T>
+Inquiry<T>* InquiryService<T>::TryGet(std::string_view key)
+{
+    // unordered_map has no heterogeneous lookup before C++20; inquiry ids fit the small-string buffer.
+    auto it = inquiryData.find(std::string(key));
+    return it != inquiryData.end() ? &it->second : nullptr;
 }
 
 template<typename T>
 void InquiryService<T>::OnMessage(Inquiry<T>& data)
 {
-    InquiryState state = data.GetState();
-    std::string inquiryId = data.GetInquiryId();
-    switch (state) 
+    TRACE_MESSAGE("InquiryService::OnMessage");
+    switch (data.GetState())
     {
     case RECEIVED:
-        // If just received, respond with a quote by publishing through the connector
+        Record(data);
+        // If just received, respond with a quote by publishing through the connector, which re-enters as QUOTED
+        if (quoter != nullptr)
+        {
+            double quote;
+            if (quoter->Quote(data.GetProduct(), data.GetSide(), data.GetQuantity(), quote))
+            {
+                data.SetPrice(quote);
+            }
+        }
         connector->Publish(data);
-        break;
+        return;
     case QUOTED:
-        // Once quoted, finalize the inquiry as DONE and broadcast the updated object
+        // Once quoted, finalize the inquiry as DONE
+        Record(data);
         data.SetState(DONE);
-        if (inquiryData.find(inquiryId) != inquiryData.end()) 
-        {
-            inquiryData.erase(inquiryId);
-        }
-        inquiryData.insert(std::make_pair(inquiryId, data));
-        for (auto& listener : listeners)
-        {
-            listener->ProcessAdd(data);
-        }
         break;
     default:
         break;
     }
+    Record(data);
+}
 
+template<typename T>
+void InquiryService<T>::Record(Inquiry<T>& data)
+{
     // If the inquiry is marked DONE, remove it from the service store
     if (data.GetState() == DONE)
     {
@@ -228,6 +293,11 @@ void InquiryService<T>::OnMessage(Inquiry<T>& data)
         inquiryData[data.GetInquiryId()] = data;
     }
 
+    if (timers != nullptr)
+    {
+        UpdateTimeout(data);
+    }
+
     // Notify all listeners about the new data or changes
     for (auto& listener : listeners)
     {
@@ -256,18 +326,68 @@ InquiryConnector<T>* InquiryService<T>::GetConnector()
 template<typename T>
 void InquiryService<T>::SendQuote(const std::string& inquiryId, double price)
 {
-    Inquiry<T>& inquiry = GetData(inquiryId);
-    inquiry.SetPrice(price);
-    inquiry.SetState(QUOTED);
-    OnMessage(inquiry);
+    Inquiry<T>* inquiry = TryGet(inquiryId);
+    if (inquiry == nullptr)
+    {
+        return;
+    }
+    // Work on a copy: a DONE inquiry is erased from the store while listeners are still being notified.
+    Inquiry<T> quoted = *inquiry;
+    quoted.SetPrice(price);
+    quoted.SetState(QUOTED);
+    OnMessage(quoted);
 }
 
 template<typename T>
 void InquiryService<T>::RejectInquiry(const std::string& inquiryId)
 {
-    Inquiry<T>& inquiry = GetData(inquiryId);
-    inquiry.SetState(REJECTED);
-    OnMessage(inquiry);
+    Inquiry<T>* inquiry = TryGet(inquiryId);
+    if (inquiry == nullptr)
+    {
+        return;
+    }
+    Inquiry<T> rejected = *inquiry;
+    rejected.SetState(REJECTED);
+    OnMessage(rejected);
+}
+
+template<typename T>
+void InquiryService<T>::Reserve(size_t inquiryCount)
+{
+    inquiryData.reserve(inquiryCount);
+    timeouts.reserve(inquiryCount);
+}
+
+template<typename T>
+void InquiryService<T>::EnableTimeouts(TimerWheel& _timers, long long _timeoutNanos)
+{
+    timers = &_timers;
+    timeoutNanos = _timeoutNanos;
+}
+
+template<typename T>
+void InquiryService<T>::UpdateTimeout(const Inquiry<T>& data)
+{
+    const std::string& inquiryId = data.GetInquiryId();
+    InquiryState state = data.GetState();
+    auto it = timeouts.find(inquiryId);
+    if (state == RECEIVED || state == QUOTED)
+    {
+        // Arm once per inquiry; a re-quote does not extend the client's deadline.
+        if (it == timeouts.end())
+        {
+            TimerId timer = timers->ScheduleAfter(timeoutNanos, [this, inquiryId]() {
+                timeouts.erase(inquiryId);
+                RejectInquiry(inquiryId);
+            });
+            timeouts.emplace(inquiryId, timer);
+        }
+    }
+    else if (it != timeouts.end())
+    {
+        timers->Cancel(it->second);
+        timeouts.erase(it);
+    }
 }
 
 /**
@@ -279,6 +399,8 @@ class InquiryConnector : public Connector<Inquiry<T>>
 {
 private:
     InquiryService<T>* service;
+    TimerWheel* timers = nullptr;
+    EventTimeClock* eventClock = nullptr;
 
     InquiryState StringToState(const std::string& stateStr);
 
@@ -289,6 +411,12 @@ public:
     void Publish(Inquiry<T>& data) override;
     void Subscribe(std::ifstream& _datafile);
     void SubscribeUpdate(Inquiry<T>& data);
+
+    // Fires due timers before each inquiry is processed.
+    void AttachTimerWheel(TimerWheel* _timers) { timers = _timers; }
+
+    // Moves the clock to each row's timestamp before the row is processed.
+    void AttachEventClock(EventTimeClock* _eventClock) { eventClock = _eventClock; }
 };
 
 template<typename T>
@@ -320,6 +448,7 @@ void InquiryConnector<T>::Subscribe(std::ifstream& _datafile)
     std::string line;
     while (std::getline(_datafile, line))
     {
+        TRACE_MESSAGE("InquiryConnector::Subscribe");
         std::stringstream ss(line);
         std::vector<std::string> tokens;
         std::string token;
@@ -333,8 +462,18 @@ void InquiryConnector<T>::Subscribe(std::ifstream& _datafile)
         long quantity = std::stol(tokens[3]);
         double price = PriceUtils::Frac2Price(tokens[4]);
         InquiryState state = StringToState(tokens[5]);
+        long long eventTime = tokens.size() > 6 && !tokens[6].empty() ? TimeUtils::ParseTimeNanos(tokens[6]) : 0;
+        if (eventClock != nullptr && eventTime != 0)
+        {
+            eventClock->Advance(eventTime);
+        }
+        if (timers != nullptr)
+        {
+            timers->Poll();
+        }
+        std::string client = tokens.size() > 7 ? tokens[7] : "";
 
-        Inquiry<T> inquiry(tokens[0], product, side, quantity, price, state);
+        Inquiry<T> inquiry(tokens[0], product, side, quantity, price, state, eventTime, std::move(client));
         service->OnMessage(inquiry);
     }
 }
@@ -7,17 +7,62 @@
 // @description This program sets up directories, generates initial data, initializes services, and processes
 //              data flows for a simulated trading environment.
 //
+// @struct TradingServices
+// - Owns one complete set of services, so a shadow graph can be built alongside the live one.
+// - Owns the timer wheel behind the GUI throttle, inquiry timeouts, periodic historical flushes and bar closing.
+//   The inbound connectors drive it once per message.
+// - Every time-dependent service reads one clock: real time by default, or an event-time clock that every inbound
+//   connector advances from the timestamps of its rows.
+//
 // @functions
 // - PrepareDirectories: Sets up or resets directories for data and results.
 // - GenerateInitialData: Creates initial data for prices, market data, trades, and inquiries.
 // - InitializeServices: Links trading services and their listeners to ensure data flows correctly.
+// - ConfigureAggregations: Builds the book -> desk -> firm and CUSIP -> tenor -> sector hierarchies.
+// - WarmUpServices: Pre-builds static tables and pushes synthetic messages through a shadow graph.
 // - ProcessDataFlows: Handles the data ingestion and processing for pricing, market data, trades, and inquiries.
+// - RunLoadTest: Drives the wired services with ramping synthetic load and reports the saturation point.
+// - RunFirstMessageBenchmark: Measures the latency of the first N messages into the live graph.
+// - InspectBooksAt: Rebuilds the order books from a replay file as of a timestamp and logs the top of each book.
+// - InspectWireFile: Decodes a binary wire file and logs the number of messages of each template.
+// - LogCompactedLog: Logs the size of a compacted historical log and the latest record of one key.
 //
 // @main
 // - Sets up directories and file paths.
 // - Generates initial datasets.
+// - Warms up the pipeline (skipped with `--no-warmup`) and pre-sizes the live services.
 // - Initializes all trading services.
-// - Processes data flows through the services.
+// - Processes data flows through the services, or runs the load test when started with `--loadtest`
+//   (optional `--rate <msgs/s>`, `--steps <n>`, `--step-seconds <s>`, `--mix <price,book,trade,inquiry>`),
+//   or the first-message benchmark with `--bench-first <n>`.
+// - Logs the transaction cost summary of the algo execution strategy after the data flows.
+// - Logs the rolled-up firm and sector positions after the data flows.
+// - Logs the RFQ hit ratio and response times, overall and per client, after the data flows.
+// - Records market data into a replay file with `--tick-store <file>`, and with `--seek "<timestamp>"` logs the books
+//   as of that time from the replay file.
+// - `--risk-batch <n>` coalesces risk: each dirty product is recomputed and persisted once per n position events or
+//   per 10 ms slice, whichever comes first.
+// - `--price-deadband <ticks>` holds back price updates whose mid and spread moved by no more than that many whole
+//   ticks (1/256 for Treasuries) since the last propagated price. The deadband is on by default with a band of 0,
+//   which holds back only unchanged prices; -1 propagates every update.
+// - `--composite` prices through a weighted composite of the feed and an internal model source, dropping sources
+//   older than 5 seconds; rows of the price file may name their source in a sixth column.
+// - `--stream-clients <n>` streams tiered quotes to n file clients per tier under result/clients, encoding each
+//   tier's message once for all its clients.
+// - `--wire-out <file>` writes the streaming and execution connector output to the file in the binary wire
+//   encoding instead of text on the console, and decodes it back after the data flows.
+// - `--print-orders` prints every execution order to the console as text.
+// - `--fix-out <file>` sends execution orders to the file as FIX 4.4 NewOrderSingle messages, one session per venue.
+// - `--venue-rate <n>` and `--product-rate <n>` limit the orders sent per second to each venue and in each product
+//   (bursts of 4); `--throttle <queue|conflate|reject>` picks what happens to excess orders (default queue).
+// - `--quote-inquiries` quotes inquiries from the latest market price by side and size bucket, through a cache that
+//   each price tick invalidates, instead of echoing the price of the inquiry.
+// - `--compact-log <bytes>` persists positions and risk to segmented logs under result/compacted, rolled at that
+//   many bytes, whose older segments are compacted in the background to the latest record per product.
+// - `--event-time` runs every service on the timestamps of the input instead of wall time, so a replay throttles,
+//   times out and stamps records as the live run did regardless of its speed.
+// - `--trace <file>` records per-message pipeline spans as Chrome trace-event JSON, sampling one message in
+//   `--trace-sample <n>`. The file is written at exit, or on SIGUSR1.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -28,6 +73,7 @@
 #include <string>
 #include <iomanip>
 #include <filesystem>
+#include <fstream>
 #include <memory>
 
 #include "soa.hpp"
@@ -48,12 +94,23 @@
 #include "AlgoStream.hpp"
 #include "AlgoStreamingService.hpp"
 #include "AlgoStreamingServiceListener.hpp"
+#include "BarService.hpp"
 #include "BondAnalytics.hpp"
+#include "BookTickStore.hpp"
+#include "TcaService.hpp"
+#include "AggregationService.hpp"
+#include "RfqAnalytics.hpp"
+#include "StreamingGateway.hpp"
+#include "WireCodec.hpp"
+#include "FixOrderEncoder.hpp"
+#include "TimerWheel.hpp"
+#include "Clocks.hpp"
 #include "DataGenerator.hpp"
 #include "ExecutionOrder.hpp"
 #include "GUIConnector.hpp"
 #include "GUIService.hpp"
 #include "GUIServiceListener.hpp"
+#include "LoadGenerator.hpp"
 #include "Logger.hpp"
 #include "PriceStream.hpp"
 #include "PriceStreamOrder.hpp"
@@ -62,9 +119,97 @@
 #include "RandomUtils.hpp"
 #include "SimpleAlgoOrderFactory.hpp"
 #include "TimeUtils.hpp"
+#include "TraceRecorder.hpp"
 
 using namespace std;
 
+// Intervals of the time-driven behaviour registered on the timer wheel.
+constexpr long long INQUIRY_TIMEOUT_NANOS = 30LL * 1000000000LL;
+constexpr long long HISTORICAL_FLUSH_NANOS = 100LL * 1000000LL;
+constexpr long long BAR_CLOSE_NANOS = 1000000000LL;
+constexpr long long RISK_SLICE_NANOS = 10LL * 1000000LL;
+constexpr long long COMPOSITE_MAX_AGE_NANOS = 5LL * 1000000000LL;
+constexpr long long THROTTLE_DRAIN_NANOS = 1000000LL;
+constexpr long ORDER_BURST = 4;
+// Rows of each generated input file per product.
+constexpr int DATA_POINTS_PER_PRODUCT = 10;
+
+// Client tiers of the streaming gateway: name, spread multiplier, extra half-spread and maximum size.
+struct StreamingTier
+{
+    const char* name;
+    double spreadMultiplier;
+    double extraHalfSpread;
+    long maxSize;
+};
+
+const StreamingTier STREAMING_TIERS[] = {
+    { "TIER1", 1.0, 0.0, 10000000 },
+    { "TIER2", 1.5, 1.0 / 256.0, 5000000 },
+    { "TIER3", 2.0, 2.0 / 256.0, 1000000 },
+};
+
+struct TradingServices
+{
+    // With an event clock the services run on input timestamps; otherwise on real time.
+    explicit TradingServices(const string& resultDir, EventTimeClock* _eventClock = nullptr,
+                             const string& guiFile = "../res/gui.txt") :
+        eventClock(_eventClock),
+        clock(_eventClock != nullptr ? static_cast<const IClock&>(*_eventClock) : RealTimeClock::Instance()),
+        timerWheel(clock),
+        algoExecutionService(make_unique<SimpleAlgoOrderFactory<Bond>>()),
+        guiService(timerWheel, clock, guiFile),
+        barService(512, clock),
+        tcaService(&pricingService, &marketDataService),
+        rfqAnalytics(clock),
+        historicalPositionService(POSITION, resultDir, clock),
+        historicalRiskService(RISK, resultDir, clock),
+        historicalExecutionService(EXECUTION, resultDir, clock),
+        historicalStreamingService(STREAMING, resultDir, clock),
+        historicalInquiryService(INQUIRY, resultDir, clock)
+    {
+    }
+
+    // Pre-size stores and holders so steady-state messages do not grow them. expectedMessages is the number of
+    // messages of each type the graph is expected to see.
+    void Reserve(size_t productCount, size_t expectedMessages)
+    {
+        marketDataService.Reserve(productCount);
+        barService.Reserve(productCount);
+        inquiryService.Reserve(expectedMessages);
+        algoStreamingService.Reserve(expectedMessages);
+        algoExecutionService.Reserve(expectedMessages);
+        tcaService.Reserve(expectedMessages);
+    }
+
+    EventTimeClock* eventClock;
+    const IClock& clock;
+    // Declared before the services so it outlives every service holding a timer on it.
+    TimerWheel timerWheel;
+
+    PricingService<Bond> pricingService;
+    AlgoStreamingService<Bond> algoStreamingService;
+    StreamingService<Bond> streamingService;
+    MarketDataService<Bond> marketDataService;
+    AlgoExecutionService<Bond> algoExecutionService;
+    ExecutionService<Bond> executionService;
+    TradeBookingService<Bond> tradeBookingService;
+    PositionService<Bond> positionService;
+    RiskService<Bond> riskService;
+    GUIService<Bond> guiService;
+    InquiryService<Bond> inquiryService;
+    BarService<Bond> barService;
+    TcaService<Bond> tcaService;
+    AggregationService<Bond> aggregationService;
+    RfqAnalytics<Bond> rfqAnalytics;
+
+    HistoricalDataService<Position<Bond>> historicalPositionService;
+    HistoricalDataService<PV01<Bond>> historicalRiskService;
+    HistoricalDataService<ExecutionOrder<Bond>> historicalExecutionService;
+    HistoricalDataService<PriceStream<Bond>> historicalStreamingService;
+    HistoricalDataService<Inquiry<Bond>> historicalInquiryService;
+};
+
 void PrepareDirectories(const string& dataDir, const string& resultDir)
 {
     if (filesystem::exists(dataDir)) {
@@ -85,7 +230,7 @@ void GenerateInitialData(
     const string& tradeFile, 
     const string& inquiryFile,
     int priceCount = 10, 
-    int marketCount = 10,
+    int marketCount = DATA_POINTS_PER_PRODUCT,
     int tradeCount = 10,
     int inquiryCount = 10
 )
@@ -97,45 +242,117 @@ void GenerateInitialData(
 	Logger::Log(LogLevel::INFO, "Data generation completed.");
 }
 
-void InitializeServices(
-    PricingService<Bond>& pricingService,
-    AlgoStreamingService<Bond>& algoStreamingService,
-    StreamingService<Bond>& streamingService,
-    MarketDataService<Bond>& marketDataService,
-    AlgoExecutionService<Bond>& algoExecutionService,
-    ExecutionService<Bond>& executionService,
-    TradeBookingService<Bond>& tradeBookingService,
-    PositionService<Bond>& positionService,
-    RiskService<Bond>& riskService,
-    GUIService<Bond>& guiService,
-    InquiryService<Bond>& inquiryService,
-    HistoricalDataService<Position<Bond>>& historicalPositionService,
-    HistoricalDataService<PV01<Bond>>& historicalRiskService,
-    HistoricalDataService<ExecutionOrder<Bond>>& historicalExecutionService,
-    HistoricalDataService<PriceStream<Bond>>& historicalStreamingService,
-    HistoricalDataService<Inquiry<Bond>>& historicalInquiryService
-)
+void InitializeServices(TradingServices& services)
 {
 	Logger::Log(LogLevel::INFO, "Initializing trading service components...");
 
-    pricingService.AddListener(algoStreamingService.GetAlgoStreamingListener());
-    pricingService.AddListener(guiService.GetGUIServiceListener());
-    algoStreamingService.AddListener(streamingService.GetStreamingServiceListener());
-    marketDataService.AddListener(algoExecutionService.GetAlgoExecutionServiceListener());
-    algoExecutionService.AddListener(executionService.GetExecutionServiceListener());
-    executionService.AddListener(tradeBookingService.GetTradeBookingServiceListener());
-    tradeBookingService.AddListener(positionService.GetPositionListener());
-    positionService.AddListener(riskService.GetRiskServiceListener());
-
-    positionService.AddListener(historicalPositionService.GetHistoricalDataServiceListener());
-    executionService.AddListener(historicalExecutionService.GetHistoricalDataServiceListener());
-    streamingService.AddListener(historicalStreamingService.GetHistoricalDataServiceListener());
-    riskService.AddListener(historicalRiskService.GetHistoricalDataServiceListener());
-    inquiryService.AddListener(historicalInquiryService.GetHistoricalDataServiceListener());
+    services.pricingService.AddListener(services.algoStreamingService.GetAlgoStreamingListener());
+    services.pricingService.AddListener(services.guiService.GetGUIServiceListener());
+    services.algoStreamingService.AddListener(services.streamingService.GetStreamingServiceListener());
+    services.marketDataService.AddDeltaListener(services.algoExecutionService.GetAlgoExecutionServiceListener());
+    // Fills are booked synchronously, so TCA has to see the order before the execution service does.
+    services.tcaService.AttachAlgoExecution(services.algoExecutionService);
+    services.algoExecutionService.AddListener(services.executionService.GetExecutionServiceListener());
+    services.tcaService.AttachExecution(services.executionService);
+    services.executionService.AddListener(services.tradeBookingService.GetTradeBookingServiceListener());
+    services.tradeBookingService.AddListener(services.positionService.GetPositionListener());
+    services.positionService.AddListener(services.riskService.GetRiskServiceListener());
+    services.pricingService.AddListener(services.barService.GetPriceListener());
+    services.tradeBookingService.AddListener(services.barService.GetTradeListener());
+    services.tradeBookingService.AddListener(services.tcaService.GetTradeListener());
+    services.tradeBookingService.AddListener(services.aggregationService.GetTradeListener());
+
+    services.positionService.AddListener(services.historicalPositionService.GetHistoricalDataServiceListener());
+    services.executionService.AddListener(services.historicalExecutionService.GetHistoricalDataServiceListener());
+    services.streamingService.AddListener(services.historicalStreamingService.GetHistoricalDataServiceListener());
+    services.riskService.AddListener(services.historicalRiskService.GetHistoricalDataServiceListener());
+    services.inquiryService.AddListener(services.historicalInquiryService.GetHistoricalDataServiceListener());
+    services.inquiryService.AddListener(&services.rfqAnalytics);
+
+    if (services.eventClock != nullptr) {
+        services.pricingService.GetConnector()->AttachEventClock(services.eventClock);
+        services.marketDataService.GetConnector()->AttachEventClock(services.eventClock);
+        services.tradeBookingService.GetConnector()->AttachEventClock(services.eventClock);
+        services.inquiryService.GetConnector()->AttachEventClock(services.eventClock);
+    }
+
+    TimerWheel& timers = services.timerWheel;
+    services.pricingService.GetConnector()->AttachTimerWheel(&timers);
+    services.marketDataService.GetConnector()->AttachTimerWheel(&timers);
+    services.tradeBookingService.GetConnector()->AttachTimerWheel(&timers);
+    services.inquiryService.GetConnector()->AttachTimerWheel(&timers);
+
+    services.inquiryService.EnableTimeouts(timers, INQUIRY_TIMEOUT_NANOS);
+    services.historicalPositionService.EnablePeriodicFlush(timers, HISTORICAL_FLUSH_NANOS);
+    services.historicalRiskService.EnablePeriodicFlush(timers, HISTORICAL_FLUSH_NANOS);
+    services.historicalExecutionService.EnablePeriodicFlush(timers, HISTORICAL_FLUSH_NANOS);
+    services.historicalStreamingService.EnablePeriodicFlush(timers, HISTORICAL_FLUSH_NANOS);
+    services.historicalInquiryService.EnablePeriodicFlush(timers, HISTORICAL_FLUSH_NANOS);
+    timers.SchedulePeriodic(BAR_CLOSE_NANOS, [&services]() { services.barService.CloseBars(); });
 
 	Logger::Log(LogLevel::INFO, "Trading service components initialized.");
 }
 
+void ConfigureAggregations(AggregationService<Bond>& aggregationService, const vector<string>& bondUniverse)
+{
+    AggregationHierarchy& books = aggregationService.GetBookHierarchy();
+    books.AddNode("FIRM", "", "firm");
+    books.AddNode("TREASURY", "FIRM", "desk");
+    for (const char* book : { "TRSY1", "TRSY2", "TRSY3" }) {
+        books.AddLeaf(book, "TREASURY");
+    }
+    books.SetDefaultParent("TREASURY");
+
+    // Tenors come from the ticker (US2Y -> 2Y); sectors follow the usual front end / belly / long end split.
+    AggregationHierarchy& products = aggregationService.GetProductHierarchy();
+    const vector<pair<string, vector<string>>> sectors = {
+        { "FrontEnd", { "2Y", "3Y" } }, { "Belly", { "5Y", "7Y", "10Y" } }, { "LongEnd", { "20Y", "30Y" } } };
+    for (const auto& [sector, tenors] : sectors) {
+        products.AddNode(sector, "", "sector");
+        for (const string& tenor : tenors) {
+            products.AddNode(tenor, sector, "tenor");
+        }
+    }
+    for (const string& cusip : bondUniverse) {
+        string tenor = ProductFactory<Bond>::QueryProduct(cusip).GetTicker().substr(2);
+        products.AddLeaf(cusip, products.Find(tenor) != nullptr ? tenor : "");
+    }
+}
+
+LoadTarget<Bond> MakeLoadTarget(TradingServices& services)
+{
+    return LoadTarget<Bond>{
+        [&services](Price<Bond>& price) { services.timerWheel.Poll(); services.pricingService.OnMessage(price); },
+        [&services](OrderBook<Bond>& orderBook) { services.timerWheel.Poll(); services.marketDataService.OnMessage(orderBook); },
+        [&services](Trade<Bond>& trade) { services.timerWheel.Poll(); services.tradeBookingService.OnMessage(trade); },
+        [&services](Inquiry<Bond>& inquiry) { services.timerWheel.Poll(); services.inquiryService.OnMessage(inquiry); }
+    };
+}
+
+void WarmUpServices(const vector<string>& bondUniverse, const string& scratchDir, long warmupMessages)
+{
+	Logger::Log(LogLevel::INFO, "Warming up service pipeline...");
+
+    ProductFactory<Bond>::Preload();
+    BondAnalytics::Preload();
+    TimeUtils::GetCurrentTime();
+
+    // The shadow graph runs the same template instantiations and code paths as the live one,
+    // but persists into a scratch directory, GUI output included, that is discarded afterwards.
+    filesystem::create_directories(scratchDir);
+    {
+        TradingServices shadow(scratchDir, nullptr, scratchDir + "/gui.txt");
+        InitializeServices(shadow);
+        shadow.Reserve(bondUniverse.size(), warmupMessages);
+
+        LoadGenerator<Bond> generator(bondUniverse, MakeLoadTarget(shadow));
+        generator.RunBurst(warmupMessages);
+    }
+    filesystem::remove_all(scratchDir);
+
+	Logger::Log(LogLevel::INFO, "Warm-up completed with " + to_string(warmupMessages) + " synthetic messages.");
+}
+
 void ProcessDataFlows(
     PricingService<Bond>& pricingService,
     MarketDataService<Bond>& marketDataService,
@@ -165,7 +382,8 @@ void ProcessDataFlows(
     {
         ifstream tradeStream(tradeFilePath.c_str());
         tradeBookingService.GetConnector()->Subscribe(tradeStream);
-		Logger::Log(LogLevel::INFO, "Trade data processing completed.");
+		Logger::Log(LogLevel::INFO, "Trade data processing completed (" + to_string(tradeBookingService.GetDuplicateCount())
+                    + " duplicate trades skipped, " + to_string(tradeBookingService.GetStaleCount()) + " stale trades rejected).");
     }
 
 	Logger::Log(LogLevel::INFO, "Processing inquiry data...");
@@ -176,8 +394,225 @@ void ProcessDataFlows(
     }
 }
 
+void RunLoadTest(
+    TradingServices& services,
+    const vector<string>& bondUniverse,
+    const LoadTestConfig& config,
+    const string& reportFilePath
+)
+{
+	Logger::Log(LogLevel::INFO, "Starting load test...");
+
+    LoadGenerator<Bond> generator(bondUniverse, MakeLoadTarget(services), config);
+    vector<LoadStepResult> results = generator.Run();
+    LoadGenerator<Bond>::WriteReport(results, config, reportFilePath);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& step = results[i];
+        ostringstream line;
+        line << "Step " << i << ": offered " << step.offeredRate << " msg/s, achieved " << step.achievedRate
+             << " msg/s, p99 " << step.total.Percentile(99) / 1000.0 << " us" << (step.saturated ? " (saturated)" : "");
+        Logger::Log(step.saturated ? LogLevel::WARNING : LogLevel::INFO, line.str());
+    }
+
+    int knee = LoadGenerator<Bond>::SaturationStep(results);
+    if (knee >= 0) {
+        Logger::Log(LogLevel::INFO, "Sustainable rate: " + to_string(results[knee].achievedRate) + " msg/s");
+    } else {
+        Logger::Log(LogLevel::WARNING, "Pipeline saturated on the first step.");
+    }
+	Logger::Log(LogLevel::INFO, "Load test report written to " + reportFilePath + " and "
+                + LoadGenerator<Bond>::StagesFileName(reportFilePath));
+}
+
+void RunFirstMessageBenchmark(
+    TradingServices& services,
+    const vector<string>& bondUniverse,
+    long messageCount,
+    const string& reportFilePath
+)
+{
+	Logger::Log(LogLevel::INFO, "Measuring latency of the first " + to_string(messageCount) + " messages...");
+
+    LoadGenerator<Bond> generator(bondUniverse, MakeLoadTarget(services));
+    vector<long long> latencies = generator.RunBurst(messageCount);
+
+    LatencyHistogram histogram;
+    ofstream out(reportFilePath);
+    out << "message,latency_ns" << endl;
+    for (size_t i = 0; i < latencies.size(); ++i) {
+        histogram.Record(latencies[i]);
+        out << i << "," << latencies[i] << endl;
+    }
+
+    ostringstream summary;
+    summary << "First message " << (latencies.empty() ? 0 : latencies.front()) / 1000.0 << " us, p50 "
+            << histogram.Percentile(50) / 1000.0 << " us, p99 " << histogram.Percentile(99) / 1000.0
+            << " us, max " << histogram.Max() / 1000.0 << " us";
+	Logger::Log(LogLevel::INFO, summary.str());
+	Logger::Log(LogLevel::INFO, "First-message latencies written to " + reportFilePath);
+}
+
+void InspectBooksAt(const string& replayFilePath, const string& timestamp)
+{
+    long long target = TimeUtils::ParseTimeNanos(timestamp);
+    BookReplayer<Bond> replayer(replayFilePath);
+    size_t tail = replayer.SeekTo(target);
+	Logger::Log(LogLevel::INFO, "Books as of " + timestamp + " (" + to_string(tail) + " ticks after the nearest checkpoint):");
+
+    // The seek must land on the same books as applying every tick up to the target.
+    BookReplayer<Bond> reference(replayFilePath);
+    size_t scanned = reference.ScanTo(target);
+    bool matches = replayer.GetBooks().size() == reference.GetBooks().size();
+    for (const auto& [productId, orderBook] : replayer.GetBooks()) {
+        const OrderBook<Bond>* expected = reference.GetBook(productId);
+        matches = matches && expected != nullptr && BookReplayer<Bond>::SameLevels(orderBook, *expected);
+    }
+    if (matches) {
+        Logger::Log(LogLevel::INFO, "Seek matches a full scan of " + to_string(scanned) + " ticks.");
+    } else {
+        Logger::Log(LogLevel::WARNING, "Seek differs from a full scan of " + to_string(scanned) + " ticks.");
+    }
+
+    for (const auto& [productId, orderBook] : replayer.GetBooks()) {
+        BidOffer top = orderBook.BestBidOffer();
+        Logger::Log(LogLevel::INFO, productId + " " + PriceUtils::Price2Frac(top.GetBidOrder().GetPrice()) + " / "
+                    + PriceUtils::Price2Frac(top.GetOfferOrder().GetPrice()));
+    }
+}
+
+void InspectWireFile(const string& wireFilePath)
+{
+    ifstream input(wireFilePath, ios::binary);
+    vector<char> data((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+
+    long priceStreams = 0;
+    long executionOrders = 0;
+    PriceStreamDecoder priceStream;
+    ExecutionOrderDecoder executionOrder;
+    size_t offset = 0;
+    while (offset + Wire::HEADER_LENGTH <= data.size()) {
+        const char* message = data.data() + offset;
+        size_t length = data.size() - offset;
+        switch (WireHeader::TemplateId(message)) {
+            case PriceStreamEncoder::TEMPLATE_ID: priceStream.Wrap(message, length); ++priceStreams; break;
+            case ExecutionOrderEncoder::TEMPLATE_ID: executionOrder.Wrap(message, length); ++executionOrders; break;
+        }
+        offset += Wire::HEADER_LENGTH + WireHeader::BlockLength(message);
+    }
+	Logger::Log(LogLevel::INFO, "Wire file " + wireFilePath + " holds " + to_string(priceStreams) + " price streams and "
+                + to_string(executionOrders) + " execution orders.");
+    if (priceStreams > 0) {
+        Logger::Log(LogLevel::INFO, "Last price stream " + string(priceStream.ProductId()) + " "
+                    + PriceUtils::Price2Frac(priceStream.BidPrice()) + " / " + PriceUtils::Price2Frac(priceStream.OfferPrice()));
+    }
+}
+
+void LogRfqSnapshot(const string& name, const RfqSnapshot& snapshot)
+{
+    Logger::Log(LogLevel::INFO, name + ": " + to_string(snapshot.received) + " received, " + to_string(snapshot.quoted)
+                + " quoted, " + to_string(snapshot.done) + " done, " + to_string(snapshot.rejected + snapshot.customerRejected)
+                + " rejected, hit ratio " + to_string(snapshot.HitRatio()) + ", response p50 "
+                + to_string(snapshot.p50ResponseNanos / 1000) + " us, p99 " + to_string(snapshot.p99ResponseNanos / 1000) + " us");
+}
+
+void LogCompactedLog(const string& name, CompactedLog& log, const string& key)
+{
+    log.Compact();
+    Logger::Log(LogLevel::INFO, name + " log: " + to_string(log.GetKeyCount()) + " keys in " + to_string(log.GetSegmentCount())
+                + " segments, " + to_string(log.GetDiskBytes()) + " bytes after " + to_string(log.GetCompactionCount()) + " compactions.");
+    string latest;
+    if (log.ReadLatest(key, latest)) {
+        Logger::Log(LogLevel::INFO, name + " latest " + key + ": " + latest);
+    }
+}
+
+ThrottlePolicy ParseThrottlePolicy(const string& text)
+{
+    if (text == "queue") return QUEUE_EXCESS;
+    if (text == "conflate") return CONFLATE_EXCESS;
+    if (text == "reject") return REJECT_EXCESS;
+    throw invalid_argument("Expected --throttle <queue|conflate|reject>");
+}
+
+LoadMix ParseLoadMix(const string& text)
+{
+    LoadMix mix;
+    vector<double> weights;
+    stringstream ss(text);
+    string field;
+    while (getline(ss, field, ',')) {
+        weights.push_back(stod(field));
+    }
+    if (weights.size() != 4) {
+        throw invalid_argument("Expected --mix <price,book,trade,inquiry>");
+    }
+    mix.prices = weights[0];
+    mix.orderBooks = weights[1];
+    mix.trades = weights[2];
+    mix.inquiries = weights[3];
+    return mix;
+}
+
+
+int main(int argc, char* argv[]) {
+    bool loadTest = false;
+    LoadTestConfig loadConfig;
+    string traceFile;
+    unsigned traceSample = 1;
+    bool warmup = true;
+    long warmupMessages = 2048;
+    long benchFirst = 0;
+    string tickStoreFile;
+    string seekTime;
+    bool eventTime = false;
+    size_t riskBatch = 1;
+    long long priceDeadband = 0;
+    bool composite = false;
+    int streamClients = 0;
+    string wireFile;
+    string fixFile;
+    bool printOrders = false;
+    double venueRate = 0.0;
+    double productRate = 0.0;
+    ThrottlePolicy throttlePolicy = QUEUE_EXCESS;
+    bool quoteInquiries = false;
+    unsigned long long compactSegmentBytes = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--loadtest") loadTest = true;
+        else if (arg == "--rate" && hasValue) loadConfig.startRate = stod(argv[++i]);
+        else if (arg == "--steps" && hasValue) loadConfig.maxSteps = stoi(argv[++i]);
+        else if (arg == "--step-seconds" && hasValue) loadConfig.stepSeconds = stod(argv[++i]);
+        else if (arg == "--mix" && hasValue) loadConfig.mix = ParseLoadMix(argv[++i]);
+        else if (arg == "--trace" && hasValue) traceFile = argv[++i];
+        else if (arg == "--trace-sample" && hasValue) traceSample = static_cast<unsigned>(stoul(argv[++i]));
+        else if (arg == "--no-warmup") warmup = false;
+        else if (arg == "--warmup-messages" && hasValue) warmupMessages = stol(argv[++i]);
+        else if (arg == "--bench-first" && hasValue) benchFirst = stol(argv[++i]);
+        else if (arg == "--tick-store" && hasValue) tickStoreFile = argv[++i];
+        else if (arg == "--seek" && hasValue) seekTime = argv[++i];
+        else if (arg == "--event-time") eventTime = true;
+        else if (arg == "--risk-batch" && hasValue) riskBatch = stoul(argv[++i]);
+        else if (arg == "--price-deadband" && hasValue) priceDeadband = stoll(argv[++i]);
+        else if (arg == "--composite") composite = true;
+        else if (arg == "--stream-clients" && hasValue) streamClients = stoi(argv[++i]);
+        else if (arg == "--wire-out" && hasValue) wireFile = argv[++i];
+        else if (arg == "--fix-out" && hasValue) fixFile = argv[++i];
+        else if (arg == "--print-orders") printOrders = true;
+        else if (arg == "--venue-rate" && hasValue) venueRate = stod(argv[++i]);
+        else if (arg == "--product-rate" && hasValue) productRate = stod(argv[++i]);
+        else if (arg == "--throttle" && hasValue) throttlePolicy = ParseThrottlePolicy(argv[++i]);
+        else if (arg == "--quote-inquiries") quoteInquiries = true;
+        else if (arg == "--compact-log" && hasValue) compactSegmentBytes = stoull(argv[++i]);
+    }
+
+    if (!traceFile.empty()) {
+        TraceRecorder::Enable(traceFile, traceSample);
+        TraceRecorder::InstallSignalHandler();
+    }
 
-int main() {
     const string dataDirectory = "./data";
     const string resultDirectory = "./result";
 
@@ -192,48 +627,167 @@ int main() {
 
     GenerateInitialData(bonds, pricePath, marketDataPath, tradePath, inquiryPath);
 
-    PricingService<Bond> pricingService;
-    AlgoStreamingService<Bond> algoStreamingService;
-    StreamingService<Bond> streamingService;
-    MarketDataService<Bond> marketDataService;
-    auto algoOrderFactory = std::make_unique<SimpleAlgoOrderFactory<Bond>>();
-    AlgoExecutionService<Bond> algoExecutionService(std::move(algoOrderFactory));
-    ExecutionService<Bond> executionService;
-    TradeBookingService<Bond> tradeBookingService;
-    PositionService<Bond> positionService;
-    RiskService<Bond> riskService;
-    GUIService<Bond> guiService;
-    InquiryService<Bond> inquiryService;
+    if (warmup) {
+        WarmUpServices(bonds, resultDirectory + "/warmup", warmupMessages);
+    }
 
-    HistoricalDataService<Position<Bond>> historicalPositionService(POSITION);
-    HistoricalDataService<PV01<Bond>> historicalRiskService(RISK);
-    HistoricalDataService<ExecutionOrder<Bond>> historicalExecutionService(EXECUTION);
-    HistoricalDataService<PriceStream<Bond>> historicalStreamingService(STREAMING);
-    HistoricalDataService<Inquiry<Bond>> historicalInquiryService(INQUIRY);
-
-    InitializeServices(
-        pricingService,
-        algoStreamingService,
-        streamingService,
-        marketDataService,
-        algoExecutionService,
-        executionService,
-        tradeBookingService,
-        positionService,
-        riskService,
-        guiService,
-        inquiryService,
-        historicalPositionService,
-        historicalRiskService,
-        historicalExecutionService,
-        historicalStreamingService,
-        historicalInquiryService
-    );
+    EventTimeClock eventClock;
+    TradingServices services(resultDirectory, eventTime ? &eventClock : nullptr);
+    size_t liveMessages = loadTest ? static_cast<size_t>(loadConfig.poolSize)
+                        : benchFirst > 0 ? static_cast<size_t>(benchFirst)
+                        : bonds.size() * DATA_POINTS_PER_PRODUCT;
+    services.Reserve(bonds.size(), liveMessages);
+    InitializeServices(services);
+    ConfigureAggregations(services.aggregationService, bonds);
+    services.pricingService.SetDeadband(priceDeadband, priceDeadband);
+    if (composite) {
+        auto pricer = make_unique<CompositePricer<Bond>>(WEIGHTED_MEAN, COMPOSITE_MAX_AGE_NANOS, services.clock);
+        pricer->AddSource(DEFAULT_PRICE_SOURCE, 1.0);
+        pricer->AddSource("MODEL", 0.5);
+        services.pricingService.AttachCompositePricer(move(pricer));
+    }
+    if (riskBatch != 1) {
+        services.riskService.EnableCoalescing(riskBatch, &services.timerWheel, RISK_SLICE_NANOS);
+    }
+    StreamingGateway<Bond> streamingGateway;
+    vector<unique_ptr<IClientSink>> streamingClients;
+    if (streamClients > 0) {
+        filesystem::create_directory(resultDirectory + "/clients");
+        for (const StreamingTier& tier : STREAMING_TIERS) {
+            streamingGateway.AddTier(tier.name, tier.spreadMultiplier, tier.extraHalfSpread, tier.maxSize);
+            for (int k = 0; k < streamClients; ++k) {
+                streamingClients.push_back(make_unique<FileClientSink>(resultDirectory + "/clients/" + tier.name + "_" + to_string(k) + ".txt"));
+                streamingGateway.Subscribe(streamingClients.back().get(), tier.name);
+            }
+        }
+        services.streamingService.AddListener(streamingGateway.GetListener());
+    }
+    ofstream wireOutput;
+    if (!wireFile.empty()) {
+        wireOutput.open(wireFile, ios::binary | ios::trunc);
+        services.streamingService.GetConnector()->SetOutput(BINARY_FORMAT, wireOutput);
+        services.executionService.GetConnector()->SetOutput(BINARY_FORMAT, &wireOutput);
+    } else if (printOrders) {
+        services.executionService.GetConnector()->SetOutput(TEXT_FORMAT, &cout);
+    }
+    if (venueRate > 0.0 || productRate > 0.0) {
+        auto throttle = make_unique<OrderThrottle<Bond>>(throttlePolicy, services.clock);
+        for (Market market : { BROKERTEC, ESPEED, CME }) {
+            throttle->SetVenueLimit(market, venueRate, ORDER_BURST);
+        }
+        throttle->SetProductLimit(productRate, ORDER_BURST);
+        services.executionService.AttachThrottle(move(throttle), &services.timerWheel, THROTTLE_DRAIN_NANOS);
+    }
+    if (compactSegmentBytes > 0) {
+        services.historicalPositionService.EnableCompactedLog(compactSegmentBytes);
+        services.historicalRiskService.EnableCompactedLog(compactSegmentBytes);
+    }
+    InquiryQuoter<Bond> inquiryQuoter;
+    if (quoteInquiries) {
+        services.pricingService.AddListener(inquiryQuoter.GetPriceListener());
+        services.inquiryService.AttachQuoter(&inquiryQuoter);
+    }
+    FixOrderSender fixSender(services.clock);
+    unique_ptr<IClientSink> fixSink;
+    if (!fixFile.empty()) {
+        fixSink = make_unique<FileClientSink>(fixFile);
+        fixSender.AddVenue(BROKERTEC, "MTH9815", "BTEC", fixSink.get());
+        fixSender.AddVenue(ESPEED, "MTH9815", "ESPEED", fixSink.get());
+        fixSender.AddVenue(CME, "MTH9815", "CME", fixSink.get());
+        services.executionService.GetConnector()->AttachFixSender(&fixSender);
+    }
 
     cout << fixed << setprecision(6);
 
-    ProcessDataFlows(pricingService, marketDataService, tradeBookingService, inquiryService,
-                     pricePath, marketDataPath, tradePath, inquiryPath);
+    if (loadTest) {
+        RunLoadTest(services, bonds, loadConfig, resultDirectory + "/loadtest.csv");
+    } else if (benchFirst > 0) {
+        RunFirstMessageBenchmark(services, bonds, benchFirst, resultDirectory + "/firstn.csv");
+    } else {
+        unique_ptr<BookTickStore<Bond>> tickStore;
+        if (!tickStoreFile.empty()) {
+            tickStore = make_unique<BookTickStore<Bond>>(tickStoreFile);
+            services.marketDataService.GetConnector()->AttachTickStore(tickStore.get());
+        }
+
+        ProcessDataFlows(services.pricingService, services.marketDataService, services.tradeBookingService, services.inquiryService,
+                         pricePath, marketDataPath, tradePath, inquiryPath);
+        // Orders the throttle still holds when the feeds end are never sent, and so never booked.
+        services.executionService.DrainThrottle();
+        size_t unsentOrders = services.executionService.DiscardPendingOrders();
+        if (unsentOrders > 0) {
+            Logger::Log(LogLevel::WARNING, to_string(unsentOrders) + " throttled orders were still queued at shutdown and were not sent.");
+        }
+        services.riskService.Flush();
+        Logger::Log(LogLevel::INFO, to_string(services.pricingService.GetFilteredCount()) + " price updates held back by the deadband.");
+        if (const CompositePricer<Bond>* pricer = services.pricingService.GetCompositePricer()) {
+            if (pricer->GetUnknownSourceCount() > 0) {
+                Logger::Log(LogLevel::WARNING, to_string(pricer->GetUnknownSourceCount()) + " prices dropped from unregistered sources.");
+            }
+            Logger::Log(LogLevel::INFO, to_string(pricer->GetEmptyCount()) + " price updates left no fresh weighted source for a composite.");
+        }
+        if (streamClients > 0) {
+            Logger::Log(LogLevel::INFO, "Streaming gateway encoded " + to_string(streamingGateway.GetEncodedCount()) + " tier messages for "
+                        + to_string(streamingGateway.GetDeliveredCount()) + " client deliveries.");
+        }
+
+        if (const TcaStats* tca = services.tcaService.TryGet("strategy:" + services.algoExecutionService.GetStrategyName())) {
+			Logger::Log(LogLevel::INFO, "TCA " + tca->GetName() + ": " + to_string(tca->GetFills()) + " fills, avg slippage "
+                        + to_string(tca->GetAverageSlippage()) + ", avg shortfall " + to_string(tca->GetAverageShortfall())
+                        + ", spread capture " + to_string(tca->GetAverageSpreadCapture()));
+        }
+        Logger::Log(LogLevel::INFO, "TCA pending: " + to_string(services.tcaService.GetPendingCount()) + " sent orders awaiting a fill, "
+                    + to_string(services.tcaService.GetUnsentCount()) + " orders never sent.");
+        for (const char* key : { "book:FIRM", "product:FrontEnd", "product:Belly", "product:LongEnd" }) {
+            const AggregateNode& node = services.aggregationService.GetData(key);
+            Logger::Log(LogLevel::INFO, "Position " + node.GetName() + ": " + to_string(node.GetPosition()) + ", PV01 "
+                        + to_string(node.GetPV01()));
+        }
+
+        if (const OrderThrottle<Bond>* throttle = services.executionService.GetThrottle()) {
+            Logger::Log(LogLevel::INFO, "Order throttle: " + to_string(throttle->GetThrottledCount()) + " orders over the limit, "
+                        + to_string(throttle->GetConflatedCount()) + " conflated, " + to_string(throttle->GetRejectedCount())
+                        + " rejected, " + to_string(unsentOrders) + " unsent at shutdown.");
+        }
+        for (const string& client : services.rfqAnalytics.GetClients()) {
+            LogRfqSnapshot("RFQ " + client, services.rfqAnalytics.GetClientSnapshot(client));
+        }
+        LogRfqSnapshot("RFQ total", services.rfqAnalytics.GetTotalSnapshot());
+        if (quoteInquiries) {
+            Logger::Log(LogLevel::INFO, "Inquiry quote cache: " + to_string(inquiryQuoter.GetHitCount()) + " hits, "
+                        + to_string(inquiryQuoter.GetMissCount()) + " misses.");
+        }
+        if (compactSegmentBytes > 0) {
+            LogCompactedLog("Position", *services.historicalPositionService.GetCompactedLog(), bonds.front());
+            LogCompactedLog("Risk", *services.historicalRiskService.GetCompactedLog(), bonds.front());
+        }
+        if (fixSink) {
+            services.executionService.GetConnector()->AttachFixSender(nullptr);
+            Logger::Log(LogLevel::INFO, to_string(fixSender.GetSentCount()) + " FIX orders written to " + fixFile);
+        }
+        if (wireOutput.is_open()) {
+            services.streamingService.GetConnector()->SetOutput(TEXT_FORMAT);
+            services.executionService.GetConnector()->SetOutput(TEXT_FORMAT, printOrders ? &cout : nullptr);
+            wireOutput.close();
+            InspectWireFile(wireFile);
+        }
+
+        if (tickStore) {
+            services.marketDataService.GetConnector()->AttachTickStore(nullptr);
+            if (tickStore->GetOutOfOrderCount() > 0) {
+                Logger::Log(LogLevel::WARNING, to_string(tickStore->GetOutOfOrderCount()) + " ticks recorded out of time order.");
+            }
+            tickStore.reset();
+            if (!seekTime.empty()) {
+                InspectBooksAt(tickStoreFile, seekTime);
+            }
+        }
+    }
+
+    if (TraceRecorder::IsEnabled()) {
+        TraceRecorder::Flush();
+		Logger::Log(LogLevel::INFO, "Pipeline trace written to " + traceFile);
+    }
 
 	Logger::Log(LogLevel::FINAL, "Trading system built successfully.");
     return 0;
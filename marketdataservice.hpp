@@ -14,10 +14,19 @@
 //   - **Order**: Represents individual market orders with price, quantity, and side (BID or OFFER).
 //   - **BidOffer**: Encapsulates the best bid and offer for a product.
 //   - **OrderBook**: Stores the bid and offer stacks for a financial product, allowing for operations
-//                    like retrieving the best bid/offer and aggregating depth.
+//                    like retrieving the best bid/offer and aggregating depth. The depth is a template
+//                    parameter: fixed depths use std::array storage with fully unrolled loops, and
+//                    DYNAMIC_DEPTH falls back to vectors sized at runtime. A book carries the event time of the
+//                    feed row it was parsed from.
+//   - **LevelChange / BookDelta**: Describe only the levels that moved between two snapshots of a book,
+//                                  with both the previous and the new price/size.
+//   - **TopOfBook**: Best bid and offer of one book, kept current from its deltas.
 //   - **MarketDataService**: Manages a collection of OrderBooks, notifies registered listeners of updates, 
-//                            and aggregates market data for efficient processing.
-//   - **MarketDataConnector**: Integrates external market data feeds into the MarketDataService.
+//                            and aggregates market data for efficient processing. Delta listeners
+//                            receive a BookDelta per update instead of the whole book.
+//   - **MarketDataConnector**: Integrates external market data feeds into the MarketDataService. Each feed row
+//                              is a full snapshot of the book, parsed by a per-depth specialized parser. It can
+//                              advance an event-time clock and drive a timer wheel as rows arrive.
 //
 // @design
 // This file provides an extensible framework for market data management, using templates to 
@@ -26,7 +35,7 @@
 // model.
 //
 // @date 2024-12-20
-// @version 1.2
+// @version 1.3
 //
 // @author Breman Thuraisingham
 // @coauthor Junhao Yu
@@ -35,7 +44,12 @@
 #define MARKET_DATA_SERVICE_HPP
 
 #include <string>
+#include <string_view>
+#include <stdexcept>
 #include <vector>
+#include <array>
+#include <utility>
+#include <charconv>
 #include <unordered_map>
 #include <algorithm>
 #include <sstream>
@@ -44,12 +58,22 @@
 #include "products.hpp"
 #include "PriceUtils.hpp"
 #include "ProductFactory.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
+#include "Clocks.hpp"
+#include "TimeUtils.hpp"
 
 using namespace std;
 
 // Enum for market sides
 enum PricingSide { BID, OFFER };
 
+// Number of levels per side on the standard feed.
+constexpr std::size_t DEFAULT_BOOK_DEPTH = 5;
+
+// Depth value selecting the runtime-sized book, for feeds whose depth is only known at startup.
+constexpr std::size_t DYNAMIC_DEPTH = 0;
+
 // Order class encapsulates price, quantity, and side of a single order
 class Order {
 public:
@@ -62,9 +86,9 @@ public:
     PricingSide GetSide() const { return side; }
 
 private:
-    double price;
-    long quantity;
-    PricingSide side;
+    double price = 0.0;
+    long quantity = 0;
+    PricingSide side = BID;
 };
 
 // BidOffer class holds the best bid and offer orders
@@ -81,17 +105,164 @@ private:
     Order offerOrder;
 };
 
-// OrderBook class manages bid and offer orders for a specific product
+// LevelChange describes one book level whose price or size moved between two snapshots
+class LevelChange {
+public:
+    LevelChange(PricingSide _side, std::size_t _level, const Order &_previous, const Order &_current)
+        : side(_side), level(_level), previous(_previous), current(_current) {}
+
+    PricingSide GetSide() const { return side; }
+    std::size_t GetLevel() const { return level; }
+    const Order& GetPrevious() const { return previous; }
+    const Order& GetCurrent() const { return current; }
+
+private:
+    PricingSide side;
+    std::size_t level;
+    Order previous;
+    Order current;
+};
+
+// BookDelta lists the changed levels of one book update. The initial delta of a product compares against an
+// empty book. The service reuses a single instance, so it is only valid for the duration of the callback.
 template<typename T>
+class BookDelta {
+public:
+    const T& GetProduct() const { return *product; }
+    const vector<LevelChange>& GetChanges() const { return changes; }
+    bool IsInitial() const { return initial; }
+    long long GetEventTime() const { return eventTime; }
+
+    void Reset(const T &_product, bool _initial, long long _eventTime) {
+        product = &_product;
+        initial = _initial;
+        eventTime = _eventTime;
+        changes.clear();
+    }
+
+    void Reserve(std::size_t levels) { changes.reserve(levels); }
+    void Add(const LevelChange &change) { changes.push_back(change); }
+
+private:
+    const T* product = nullptr;
+    bool initial = false;
+    long long eventTime = 0;
+    vector<LevelChange> changes;
+};
+
+// TopOfBook keeps the best bid and offer of one book from its deltas. It mirrors the levels so that only a best
+// level that worsens needs a rescan of its side; ties keep the first level, as in OrderBook::BestBidOffer.
+class TopOfBook {
+public:
+    template<typename T>
+    void Apply(const BookDelta<T>& delta) {
+        for (const auto& change : delta.GetChanges()) {
+            if (change.GetSide() == BID) {
+                Update(bids, bestBid, change, true);
+            } else {
+                Update(offers, bestOffer, change, false);
+            }
+        }
+    }
+
+    BidOffer GetBidOffer() const {
+        return BidOffer(bids.empty() ? Order(0.0, 0, BID) : bids[bestBid], offers.empty() ? Order(0.0, 0, OFFER) : offers[bestOffer]);
+    }
+
+private:
+    static bool Better(double price, double than, bool higherIsBetter) {
+        return higherIsBetter ? price > than : price < than;
+    }
+
+    static void Update(vector<Order>& levels, std::size_t& best, const LevelChange& change, bool higherIsBetter) {
+        std::size_t level = change.GetLevel();
+        if (level >= levels.size()) {
+            levels.resize(level + 1, Order(0.0, 0, change.GetSide()));
+        }
+        double previous = levels[level].GetPrice();
+        double price = change.GetCurrent().GetPrice();
+        levels[level] = change.GetCurrent();
+
+        if (level == best) {
+            if (Better(previous, price, higherIsBetter)) {
+                best = 0;
+                for (std::size_t i = 1; i < levels.size(); ++i) {
+                    if (Better(levels[i].GetPrice(), levels[best].GetPrice(), higherIsBetter)) best = i;
+                }
+            }
+        } else if (Better(price, levels[best].GetPrice(), higherIsBetter) || (price == levels[best].GetPrice() && level < best)) {
+            best = level;
+        }
+    }
+
+    vector<Order> bids;
+    vector<Order> offers;
+    std::size_t bestBid = 0;
+    std::size_t bestOffer = 0;
+};
+
+// OrderBook class manages bid and offer orders for a specific product, with Depth levels per side
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
 class OrderBook {
 public:
+    using Stack = array<Order, Depth>;
+
+    OrderBook() = default;
+    OrderBook(const T &_product, const Stack &_bidStack, const Stack &_offerStack)
+        : product(_product), bidStack(_bidStack), offerStack(_offerStack) {}
+
+    const T& GetProduct() const { return product; }
+    Stack& GetBidStack() { return bidStack; }
+    Stack& GetOfferStack() { return offerStack; }
+    const Stack& GetBidStack() const { return bidStack; }
+    const Stack& GetOfferStack() const { return offerStack; }
+    std::size_t GetDepth() const { return Depth; }
+
+    // Nanoseconds since the epoch of the feed row, or 0 when unknown.
+    long long GetEventTime() const { return eventTime; }
+    void SetEventTime(long long _eventTime) { eventTime = _eventTime; }
+
+    BidOffer BestBidOffer() const {
+        return BestBidOffer(make_index_sequence<Depth>{});
+    }
+
+private:
+    // Fold over the levels so the scan is unrolled for each depth; ties keep the first level.
+    template<std::size_t... I>
+    BidOffer BestBidOffer(index_sequence<I...>) const {
+        std::size_t bestBid = 0;
+        std::size_t bestOffer = 0;
+        ((bestBid = bidStack[I].GetPrice() > bidStack[bestBid].GetPrice() ? I : bestBid), ...);
+        ((bestOffer = offerStack[I].GetPrice() < offerStack[bestOffer].GetPrice() ? I : bestOffer), ...);
+        return BidOffer(bidStack[bestBid], offerStack[bestOffer]);
+    }
+
+    T product;
+    Stack bidStack{};
+    Stack offerStack{};
+    long long eventTime = 0;
+};
+
+// Runtime-depth fallback: the stacks are vectors and may hold any number of levels
+template<typename T>
+class OrderBook<T, DYNAMIC_DEPTH> {
+public:
+    using Stack = vector<Order>;
+
     OrderBook() = default;
-    OrderBook(const T &_product, const vector<Order> &_bidStack, const vector<Order> &_offerStack)
+    OrderBook(const T &_product, const Stack &_bidStack, const Stack &_offerStack)
         : product(_product), bidStack(_bidStack), offerStack(_offerStack) {}
 
     const T& GetProduct() const { return product; }
-    vector<Order>& GetBidStack() { return bidStack; }
-    vector<Order>& GetOfferStack() { return offerStack; }
+    Stack& GetBidStack() { return bidStack; }
+    Stack& GetOfferStack() { return offerStack; }
+    const Stack& GetBidStack() const { return bidStack; }
+    const Stack& GetOfferStack() const { return offerStack; }
+    std::size_t GetDepth() const { return bidStack.size(); }
+
+    // Nanoseconds since the epoch of the feed row, or 0 when unknown.
+    long long GetEventTime() const { return eventTime; }
+    void SetEventTime(long long _eventTime) { eventTime = _eventTime; }
 
     BidOffer BestBidOffer() const {
         auto bestBid = max_element(bidStack.begin(), bidStack.end(), ComparePriceAsc);
@@ -105,61 +276,151 @@ private:
     }
 
     T product;
-    vector<Order> bidStack;
-    vector<Order> offerStack;
+    Stack bidStack;
+    Stack offerStack;
+    long long eventTime = 0;
 };
 
 // forward declaration
-template<typename T>
+template<typename T, std::size_t Depth>
 class MarketDataConnector;
 
+template<typename T, std::size_t Depth>
+class BookTickStore;
+
 // MarketDataService manages and disseminates market data
-template<typename T>
-class MarketDataService : public Service<string, OrderBook<T>> {
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class MarketDataService : public Service<string, OrderBook<T, Depth>> {
 public:
-    MarketDataService() : connector(new MarketDataConnector<T>(this)), bookDepth(5) {}
+    using Book = OrderBook<T, Depth>;
 
-    OrderBook<T>& GetData(string key) override {
-        if (orderBookMap.find(key) == orderBookMap.end()) {
-            orderBookMap.emplace(key, OrderBook<T>(ProductFactory<T>::QueryProduct(key), {}, {}));
+    // runtimeDepth is only used when Depth is DYNAMIC_DEPTH.
+    explicit MarketDataService(std::size_t _runtimeDepth = DEFAULT_BOOK_DEPTH)
+        : connector(new MarketDataConnector<T, Depth>(this)), runtimeDepth(_runtimeDepth) {
+        delta.Reserve(2 * GetBookDepth());
+    }
+
+    ~MarketDataService() { delete connector; }
+
+    Book& GetData(string key) override {
+        Book* orderBook = TryGet(key);
+        if (orderBook == nullptr) {
+            throw runtime_error("Key not found: " + key);
         }
-        return orderBookMap[key];
+        return *orderBook;
+    }
+
+    Book* TryGet(string_view key) override {
+        // unordered_map has no heterogeneous lookup before C++20; product ids fit the small-string buffer.
+        auto it = orderBookMap.find(string(key));
+        return it != orderBookMap.end() ? &it->second : nullptr;
+    }
+
+    Book* Find(const T& product) {
+        auto it = orderBookMap.find(product.GetProductId());
+        return it != orderBookMap.end() ? &it->second : nullptr;
     }
 
-    void OnMessage(OrderBook<T>& data) override {
+    // Returns the stored book for a product, creating an empty one on first sight.
+    Book& GetOrCreate(const string& productId) {
+        auto it = orderBookMap.find(productId);
+        if (it == orderBookMap.end()) {
+            it = orderBookMap.emplace(productId, Book(ProductFactory<T>::QueryProduct(productId), {}, {})).first;
+        }
+        return it->second;
+    }
+
+    void OnMessage(Book& data) override {
+        TRACE_MESSAGE("MarketDataService::OnMessage");
         const auto &key = data.GetProduct().GetProductId();
-        orderBookMap[key] = data;
+        auto it = orderBookMap.find(key);
+        bool initial = it == orderBookMap.end();
+        if (initial) {
+            it = orderBookMap.emplace(key, Book(data.GetProduct(), {}, {})).first;
+        }
+        Book &stored = it->second;
+
+        // Diffing is only paid for when someone consumes deltas.
+        if (!deltaListeners.empty()) {
+            delta.Reset(stored.GetProduct(), initial, data.GetEventTime());
+            DiffSide(stored.GetBidStack(), data.GetBidStack(), BID);
+            DiffSide(stored.GetOfferStack(), data.GetOfferStack(), OFFER);
+        }
+
+        // Only the levels are copied; the stored product is already the right one.
+        if (&stored != &data) {
+            stored.GetBidStack() = data.GetBidStack();
+            stored.GetOfferStack() = data.GetOfferStack();
+            stored.SetEventTime(data.GetEventTime());
+        }
+
         for (auto& listener : listeners) {
             listener->ProcessAdd(data);
         }
+        if (!delta.GetChanges().empty()) {
+            for (auto& listener : deltaListeners) {
+                listener->ProcessUpdate(delta);
+            }
+        }
     }
 
-    void AddListener(ServiceListener<OrderBook<T>>* listener) override {
+    void AddListener(ServiceListener<Book>* listener) override {
         listeners.push_back(listener);
     }
 
-    const vector<ServiceListener<OrderBook<T>>*>& GetListeners() const override {
+    // Subscribe to changed levels only. Delta listeners are called through ProcessUpdate.
+    void AddDeltaListener(ServiceListener<BookDelta<T>>* listener) {
+        deltaListeners.push_back(listener);
+    }
+
+    const vector<ServiceListener<BookDelta<T>>*>& GetDeltaListeners() const {
+        return deltaListeners;
+    }
+
+    const vector<ServiceListener<Book>*>& GetListeners() const override {
         return listeners;
     }
 
-    MarketDataConnector<T>* GetConnector() { return connector; }
-    int GetBookDepth() const { return bookDepth; }
+    MarketDataConnector<T, Depth>* GetConnector() { return connector; }
+    std::size_t GetBookDepth() const { return Depth == DYNAMIC_DEPTH ? runtimeDepth : Depth; }
 
-    const BidOffer& BestBidOffer(const string &productId) {
-        return orderBookMap[productId].BestBidOffer();
+    // Pre-size the book store for the expected product universe.
+    void Reserve(size_t productCount) { orderBookMap.reserve(productCount); }
+
+    BidOffer BestBidOffer(const string &productId) {
+        return GetOrCreate(productId).BestBidOffer();
     }
 
-    const OrderBook<T>& AggregateDepth(const string &productId) {
-        auto &orderBook = orderBookMap[productId];
-        orderBook = OrderBook<T>(orderBook.GetProduct(), Aggregate(orderBook.GetBidStack(), BID), Aggregate(orderBook.GetOfferStack(), OFFER));
+    // Merges levels quoted at the same price. Fixed-depth snapshots already carry one level per price,
+    // so only the runtime-depth book needs the merge.
+    const Book& AggregateDepth(const string &productId) {
+        auto &orderBook = GetOrCreate(productId);
+        if constexpr (Depth == DYNAMIC_DEPTH) {
+            orderBook = Book(orderBook.GetProduct(), Aggregate(orderBook.GetBidStack(), BID), Aggregate(orderBook.GetOfferStack(), OFFER));
+        }
         return orderBook;
     }
 
 private:
-    MarketDataConnector<T>* connector;
-    unordered_map<string, OrderBook<T>> orderBookMap;
-    vector<ServiceListener<OrderBook<T>>*> listeners;
-    int bookDepth;
+    MarketDataConnector<T, Depth>* connector;
+    unordered_map<string, Book> orderBookMap;
+    vector<ServiceListener<Book>*> listeners;
+    vector<ServiceListener<BookDelta<T>>*> deltaListeners;
+    BookDelta<T> delta;
+    std::size_t runtimeDepth;
+
+    // Records every level whose price or size differs. Missing levels of a runtime-depth book count as empty.
+    template<typename Stack>
+    void DiffSide(const Stack& before, const Stack& after, PricingSide side) {
+        std::size_t levels = max(before.size(), after.size());
+        for (std::size_t i = 0; i < levels; ++i) {
+            Order previous = i < before.size() ? before[i] : Order(0.0, 0, side);
+            Order current = i < after.size() ? after[i] : Order(0.0, 0, side);
+            if (previous.GetPrice() != current.GetPrice() || previous.GetQuantity() != current.GetQuantity()) {
+                delta.Add(LevelChange(side, i, previous, current));
+            }
+        }
+    }
 
     static vector<Order> Aggregate(const vector<Order>& stack, PricingSide side) {
         unordered_map<double, long> priceMap;
@@ -176,45 +437,152 @@ private:
     }
 };
 
-// MarketDataConnector feeds data into MarketDataService
-template<typename T>
-class MarketDataConnector : public Connector<OrderBook<T>> {
+// MarketDataConnector feeds data into MarketDataService.
+// A row is "Timestamp,CUSIP" followed by Bid,BidSize,Ask,AskSize for each level, and replaces the stored book.
+template<typename T, std::size_t Depth = DEFAULT_BOOK_DEPTH>
+class MarketDataConnector : public Connector<OrderBook<T, Depth>> {
 public:
-    explicit MarketDataConnector(MarketDataService<T>* _service) : service(_service) {}
+    using Book = OrderBook<T, Depth>;
 
-    void Publish(OrderBook<T>& data) override {}
+    explicit MarketDataConnector(MarketDataService<T, Depth>* _service) : service(_service) {}
+
+    void Publish(Book& data) override {}
     void Subscribe(ifstream& dataStream) {
         string line;
         getline(dataStream, line); // Skip header
 
         while (getline(dataStream, line)) {
-            auto orderBook = ParseOrderBook(line);
+            TRACE_MESSAGE("MarketDataConnector::Subscribe");
+            Book& orderBook = ParseRow(line, service->GetBookDepth(), [this](string_view productId) -> Book& { return Scratch(productId); });
+            if (eventClock != nullptr) {
+                eventClock->Advance(orderBook.GetEventTime());
+            }
+            if (timers != nullptr) {
+                timers->Poll();
+            }
+            if (tickStore != nullptr) {
+                tickStore->Record(string_view(line).substr(0, line.find(',')), orderBook);
+            }
             service->OnMessage(orderBook);
         }
     }
 
-private:
-    MarketDataService<T>* service;
-
-    OrderBook<T> ParseOrderBook(const string &line) {
-        stringstream ss(line);
-        vector<string> fields;
-        string field;
+    // Records every parsed book into a tick store as it is fed to the service.
+    void AttachTickStore(BookTickStore<T, Depth>* store) { tickStore = store; }
+
+    // Fires due timers before each row is processed.
+    void AttachTimerWheel(TimerWheel* _timers) { timers = _timers; }
+
+    // Moves the clock to each row's timestamp before the row is processed.
+    void AttachEventClock(EventTimeClock* _eventClock) { eventClock = _eventClock; }
+
+    // Parses one feed row, including its timestamp, into the book returned by getBook(productId) and returns that book.
+    // depth is only read for DYNAMIC_DEPTH; fixed depths use the specialized parser.
+    template<typename GetBook>
+    static Book& ParseRow(string_view line, std::size_t depth, GetBook getBook) {
+        if constexpr (Depth == DYNAMIC_DEPTH) {
+            vector<string_view> fields;
+            fields.reserve(HEADER_FIELDS + FIELDS_PER_LEVEL * depth);
+            Split(line, [&](string_view field) { fields.push_back(field); return true; });
+            if (fields.size() < HEADER_FIELDS + FIELDS_PER_LEVEL * depth) {
+                throw invalid_argument("Order book row has fewer levels than the configured depth: " + string(line));
+            }
+
+            Book& orderBook = getBook(fields[1]);
+            orderBook.SetEventTime(TimeUtils::ParseTimeNanos(fields[0]));
+            orderBook.GetBidStack().clear();
+            orderBook.GetOfferStack().clear();
+            for (std::size_t i = 0; i < depth; ++i) {
+                const string_view* level = &fields[HEADER_FIELDS + FIELDS_PER_LEVEL * i];
+                orderBook.GetBidStack().emplace_back(ParsePrice(level[0]), ParseQuantity(level[1]), BID);
+                orderBook.GetOfferStack().emplace_back(ParsePrice(level[2]), ParseQuantity(level[3]), OFFER);
+            }
+            return orderBook;
+        } else {
+            constexpr std::size_t FIELD_COUNT = HEADER_FIELDS + FIELDS_PER_LEVEL * Depth;
+            array<string_view, FIELD_COUNT> fields;
+            std::size_t count = 0;
+            Split(line, [&](string_view field) { fields[count++] = field; return count < FIELD_COUNT; });
+            if (count < FIELD_COUNT) {
+                throw invalid_argument("Order book row has fewer levels than the book depth: " + string(line));
+            }
+
+            Book& orderBook = getBook(fields[1]);
+            orderBook.SetEventTime(TimeUtils::ParseTimeNanos(fields[0]));
+            ParseLevels(fields, orderBook, make_index_sequence<Depth>{});
+            return orderBook;
+        }
+    }
 
-        while (getline(ss, field, ',')) {
-            fields.push_back(field);
+    // Writes a book in the feed row layout, without the timestamp: CUSIP,Bid1,BidSize1,Ask1,AskSize1,...
+    static void WriteRow(ostream& out, const Book& orderBook) {
+        out << orderBook.GetProduct().GetProductId();
+        const auto& bids = orderBook.GetBidStack();
+        const auto& offers = orderBook.GetOfferStack();
+        for (std::size_t i = 0; i < bids.size() && i < offers.size(); ++i) {
+            out << ',' << PriceUtils::Price2Frac(bids[i].GetPrice()) << ',' << bids[i].GetQuantity()
+                << ',' << PriceUtils::Price2Frac(offers[i].GetPrice()) << ',' << offers[i].GetQuantity();
         }
+    }
 
-        const auto &productId = fields[1];
-        auto &orderBook = service->GetData(productId);
+private:
+    static constexpr std::size_t HEADER_FIELDS = 2;
+    static constexpr std::size_t FIELDS_PER_LEVEL = 4;
+
+    MarketDataService<T, Depth>* service;
+    BookTickStore<T, Depth>* tickStore = nullptr;
+    TimerWheel* timers = nullptr;
+    EventTimeClock* eventClock = nullptr;
+    Book scratch;
+
+    // Rows are parsed into a reusable book so the service can diff them against the stored one.
+    // The product is only looked up again when the feed moves to another product.
+    Book& Scratch(string_view productId) {
+        if (scratch.GetProduct().GetProductId() != productId) {
+            scratch = Book(ProductFactory<T>::QueryProduct(string(productId)), {}, {});
+        }
+        return scratch;
+    }
 
-        for (int i = 0; i < service->GetBookDepth(); ++i) {
-            orderBook.GetBidStack().emplace_back(PriceUtils::Frac2Price(fields[4 * i + 2]), stol(fields[4 * i + 3]), BID);
-            orderBook.GetOfferStack().emplace_back(PriceUtils::Frac2Price(fields[4 * i + 4]), stol(fields[4 * i + 5]), OFFER);
+    // Calls onField for each comma-separated field until it returns false.
+    template<typename OnField>
+    static void Split(string_view line, OnField onField) {
+        std::size_t start = 0;
+        while (start <= line.size()) {
+            std::size_t comma = line.find(',', start);
+            std::size_t end = comma == string_view::npos ? line.size() : comma;
+            if (!onField(line.substr(start, end - start)) || comma == string_view::npos) return;
+            start = comma + 1;
         }
+    }
+
+    template<std::size_t N, std::size_t... I>
+    static void ParseLevels(const array<string_view, N>& fields, Book& orderBook, index_sequence<I...>) {
+        (ParseLevel<I>(fields, orderBook), ...);
+    }
 
-        return service->AggregateDepth(productId);
+    template<std::size_t I, std::size_t N>
+    static void ParseLevel(const array<string_view, N>& fields, Book& orderBook) {
+        constexpr std::size_t offset = HEADER_FIELDS + FIELDS_PER_LEVEL * I;
+        orderBook.GetBidStack()[I] = Order(ParsePrice(fields[offset]), ParseQuantity(fields[offset + 1]), BID);
+        orderBook.GetOfferStack()[I] = Order(ParsePrice(fields[offset + 2]), ParseQuantity(fields[offset + 3]), OFFER);
+    }
+
+    static double ParsePrice(string_view field) {
+        return PriceUtils::Frac2Price(string(field));
+    }
+
+    static long ParseQuantity(string_view field) {
+        long quantity = 0;
+        auto [end, error] = from_chars(field.data(), field.data() + field.size(), quantity);
+        if (error != errc()) {
+            throw invalid_argument("Invalid order book quantity: " + string(field));
+        }
+        return quantity;
     }
 };
 
+// The tick store builds on the connector row format, so it is defined after it.
+#include "BookTickStore.hpp"
+
 #endif
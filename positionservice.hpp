@@ -5,15 +5,20 @@
 //
 // @class Position
 // Represents a financial position in a particular book, providing utilities to manage and query book-specific and aggregate positions.
+// It carries the event time of the last trade applied to it.
 //
 // @class PositionService
 // Manages a collection of positions across multiple books and securities. Provides integration with trade booking services and listeners for position updates.
+// New trades are published as ProcessAdd; amendments and cancellations are applied as O(1) deltas and published as ProcessUpdate.
 //
 // @class PositionServiceListener
 // A specialized listener to handle trade events and update the corresponding positions in PositionService.
+// Trade adds, amendments (ProcessUpdate) and cancellations (ProcessRemove) are all forwarded.
 //
 // @features
-// - **Position Management**: Handles per-book and aggregate positions for a given financial product.
+// - **Position Management**: Handles per-book and aggregate positions for a given financial product. The aggregate is kept
+//   incrementally, so reading it does not walk the books.
+// - **Corrections**: Reverses a cancelled trade, or the original version of an amended one, without replaying trade history.
 // - **Integration**: Supports real-time updates from a trade booking service.
 // - **Event Notification**: Publishes updates to registered listeners for further processing.
 //
@@ -31,9 +36,9 @@
 
 #include <string>
 #include <map>
-#include <numeric>
 #include "soa.hpp"
 #include "tradebookingservice.hpp"
+#include "TraceRecorder.hpp"
 
 using namespace std;
 
@@ -52,6 +57,8 @@ public:
     long GetPosition(const string &book) const;
     long GetAggregatePosition() const;
     void AddPosition(const string &book, long position);
+    long long GetEventTime() const;
+    void SetEventTime(long long _eventTime);
 
     template<typename S>
     friend ostream& operator<<(ostream& output, const Position<S>& position);
@@ -59,6 +66,8 @@ public:
 private:
     T product;
     map<string, long> bookPositionData;
+    long aggregatePosition = 0;
+    long long eventTime = 0;
 };
 
 template<typename T>
@@ -77,13 +86,23 @@ long Position<T>::GetPosition(const string &book) const {
 
 template<typename T>
 long Position<T>::GetAggregatePosition() const {
-    return accumulate(bookPositionData.begin(), bookPositionData.end(), 0L, 
-                      [](long sum, const auto& pair) { return sum + pair.second; });
+    return aggregatePosition;
 }
 
 template<typename T>
 void Position<T>::AddPosition(const string &book, long position) {
     bookPositionData[book] += position;
+    aggregatePosition += position;
+}
+
+template<typename T>
+long long Position<T>::GetEventTime() const {
+    return eventTime;
+}
+
+template<typename T>
+void Position<T>::SetEventTime(long long _eventTime) {
+    eventTime = _eventTime;
 }
 
 template<typename T>
@@ -107,7 +126,7 @@ class PositionServiceListener;
 template<typename T>
 class PositionService : public Service<string, Position<T>> {
 private:
-    map<string, Position<T>> positionData;
+    map<string, Position<T>, less<>> positionData;
     vector<ServiceListener<Position<T>>*> listeners;
     unique_ptr<PositionServiceListener<T>> positionListener;
 
@@ -116,12 +135,16 @@ public:
     ~PositionService() = default;
 
     Position<T>& GetData(string key) override;
+    Position<T>* TryGet(string_view key) override;
+    Position<T>* Find(const T& product);
     void OnMessage(Position<T>& data) override;
     void AddListener(ServiceListener<Position<T>>* listener) override;
     const vector<ServiceListener<Position<T>>*>& GetListeners() const override;
 
     PositionServiceListener<T>* GetPositionListener();
     void AddTrade(const Trade<T>& trade);
+    void AmendTrade(const Trade<T>& trade);
+    void CancelTrade(const Trade<T>& trade);
 };
 
 template<typename T>
@@ -129,11 +152,22 @@ PositionService<T>::PositionService() : positionListener(make_unique<PositionSer
 
 template<typename T>
 Position<T>& PositionService<T>::GetData(string key) {
-    auto it = positionData.find(key);
-    if (it != positionData.end()) {
-        return it->second;
+    Position<T>* position = TryGet(key);
+    if (position == nullptr) {
+        throw runtime_error("Key not found: " + key);
     }
-    throw runtime_error("Key not found: " + key);
+    return *position;
+}
+
+template<typename T>
+Position<T>* PositionService<T>::TryGet(string_view key) {
+    auto it = positionData.find(key);
+    return it != positionData.end() ? &it->second : nullptr;
+}
+
+template<typename T>
+Position<T>* PositionService<T>::Find(const T& product) {
+    return TryGet(product.GetProductId());
 }
 
 template<typename T>
@@ -158,19 +192,49 @@ PositionServiceListener<T>* PositionService<T>::GetPositionListener() {
 
 template<typename T>
 void PositionService<T>::AddTrade(const Trade<T>& trade) {
+    TRACE_SPAN("PositionService::AddTrade");
     const auto& product = trade.GetProduct();
     const string& productId = product.GetProductId();
     const string& book = trade.GetBook();
-    long quantity = (trade.GetSide() == BUY ? trade.GetQuantity() : -trade.GetQuantity());
+    long quantity = trade.GetSignedQuantity();
 
     Position<T>& position = positionData.try_emplace(productId, product).first->second;
     position.AddPosition(book, quantity);
+    position.SetEventTime(trade.GetEventTime());
 
     for (auto* listener : listeners) {
         listener->ProcessAdd(position);
     }
 }
 
+template<typename T>
+void PositionService<T>::AmendTrade(const Trade<T>& trade) {
+    TRACE_SPAN("PositionService::AmendTrade");
+    const auto& product = trade.GetProduct();
+    Position<T>& position = positionData.try_emplace(product.GetProductId(), product).first->second;
+    position.AddPosition(trade.GetOriginalBook(), -trade.GetOriginalSignedQuantity());
+    position.AddPosition(trade.GetBook(), trade.GetSignedQuantity());
+    position.SetEventTime(trade.GetEventTime());
+
+    for (auto* listener : listeners) {
+        listener->ProcessUpdate(position);
+    }
+}
+
+template<typename T>
+void PositionService<T>::CancelTrade(const Trade<T>& trade) {
+    TRACE_SPAN("PositionService::CancelTrade");
+    const auto& product = trade.GetProduct();
+    Position<T>& position = positionData.try_emplace(product.GetProductId(), product).first->second;
+    position.AddPosition(trade.GetBook(), -trade.GetSignedQuantity());
+    // TradeBookingService stamps a cancelled trade with the event time of the cancel.
+    position.SetEventTime(trade.GetEventTime());
+
+    for (auto* listener : listeners) {
+        listener->ProcessUpdate(position);
+    }
+}
+
 /**
  * PositionServiceListener subscribes to trade booking service and updates PositionService.
  */
@@ -182,8 +246,8 @@ private:
 public:
     explicit PositionServiceListener(PositionService<T>* service);
     void ProcessAdd(Trade<T>& data) override;
-    void ProcessRemove(Trade<T>& data) override {}
-    void ProcessUpdate(Trade<T>& data) override {}
+    void ProcessRemove(Trade<T>& data) override;
+    void ProcessUpdate(Trade<T>& data) override;
 };
 
 template<typename T>
@@ -194,4 +258,14 @@ void PositionServiceListener<T>::ProcessAdd(Trade<T>& data) {
     positionService->AddTrade(data);
 }
 
+template<typename T>
+void PositionServiceListener<T>::ProcessRemove(Trade<T>& data) {
+    positionService->CancelTrade(data);
+}
+
+template<typename T>
+void PositionServiceListener<T>::ProcessUpdate(Trade<T>& data) {
+    positionService->AmendTrade(data);
+}
+
 #endif
@@ -8,6 +8,12 @@
 //
 // @class PricingService
 // @description Manages a collection of prices, keyed by product identifiers, and notifies listeners of updates.
+//              With a deadband set, mid and spread are compared against the last price propagated for the product
+//              in whole ticks of the product's tick size, and an update within both bands is stored but not
+//              propagated. A mid of two on-tick prices can sit on a half tick, so a half-tick move always
+//              counts as a move.
+//              With a CompositePricer attached, prices arriving from named sources are combined first and only
+//              the composite is stored and published; the per-source inputs stay readable on the pricer.
 //
 // @class PricingConnector
 // @description An inbound connector that subscribes pricing data from external sources and feeds it into the `PricingService`.
@@ -16,18 +22,28 @@
 // - GetProduct: Retrieves the associated product.
 // - GetMid: Returns the mid price.
 // - GetBidOfferSpread: Returns the bid/offer spread.
+// - GetEventTime: Returns the event time of the price in nanoseconds since the epoch, or 0 when unknown.
 // - operator<<: Outputs a formatted representation of the price.
 //
 // @methods (PricingService)
 // - GetData: Retrieves a price object by product identifier.
-// - OnMessage: Handles updates to pricing data.
+// - TryGet: Retrieves a price object by product identifier, or nullptr if none exists.
+// - Find: Retrieves the price object for a product, or nullptr if none exists.
+// - OnMessage: Stores a price and notifies listeners, unless it falls within the deadband.
+// - SetDeadband: Sets the mid and spread deadbands in whole ticks; a band of 0 drops only updates that did not move.
+//   A negative band turns the deadband off.
+// - GetFilteredCount: Returns the number of updates held back by the deadband.
+// - OnSourceMessage: Routes a price from a named source through the composite pricer, if one is attached.
+// - AttachCompositePricer / GetCompositePricer: Set and access the composite pricer.
 // - AddListener: Registers a listener for price updates.
 // - GetListeners: Returns all registered listeners.
 // - GetConnector: Provides access to the associated pricing connector.
 //
 // @methods (PricingConnector)
 // - Publish: No-op, as this connector is inbound only.
-// - Subscribe: Reads and parses pricing data from an input stream.
+// - Subscribe: Reads and parses pricing data from an input stream. An optional sixth column names the source.
+// - AttachTimerWheel: Drives a timer wheel from the price feed.
+// - AttachEventClock: Advances an event-time clock to the timestamp of each price.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -43,10 +59,16 @@
 #include <map>
 #include <fstream>
 #include <utility>
+#include <cmath>
 #include "soa.hpp"
 #include "products.hpp"
 #include "PriceUtils.hpp"
 #include "ProductFactory.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
+#include "Clocks.hpp"
+#include "TimeUtils.hpp"
+#include "CompositePricer.hpp"
 
 /**
  * A price object consisting of mid and bid/offer spread.
@@ -56,12 +78,13 @@ template<typename T>
 class Price {
 public:
     Price() = default;
-    Price(const T& _product, double _mid, double _bidOfferSpread);
+    Price(const T& _product, double _mid, double _bidOfferSpread, long long _eventTime = 0);
     ~Price() = default;
 
     const T& GetProduct() const;
     double GetMid() const;
     double GetBidOfferSpread() const;
+    long long GetEventTime() const;
 
     template<typename S>
     friend ostream& operator<<(ostream& output, const Price<S>& price);
@@ -70,11 +93,12 @@ private:
     T product;
     double mid;
     double bidOfferSpread;
+    long long eventTime = 0;
 };
 
 template<typename T>
-Price<T>::Price(const T& _product, double _mid, double _bidOfferSpread)
-    : product(_product), mid(_mid), bidOfferSpread(_bidOfferSpread) {}
+Price<T>::Price(const T& _product, double _mid, double _bidOfferSpread, long long _eventTime)
+    : product(_product), mid(_mid), bidOfferSpread(_bidOfferSpread), eventTime(_eventTime) {}
 
 template<typename T>
 const T& Price<T>::GetProduct() const {
@@ -91,6 +115,11 @@ double Price<T>::GetBidOfferSpread() const {
     return bidOfferSpread;
 }
 
+template<typename T>
+long long Price<T>::GetEventTime() const {
+    return eventTime;
+}
+
 template<typename T>
 ostream& operator<<(ostream& output, const Price<T>& price) {
     output << price.GetProduct().GetProductId() << " Mid: " << price.GetMid()
@@ -102,6 +131,9 @@ ostream& operator<<(ostream& output, const Price<T>& price) {
 template<typename T>
 class PricingConnector;
 
+// Source of rows in a price file without a source column.
+const string DEFAULT_PRICE_SOURCE = "FEED";
+
 /**
  * Pricing Service managing mid prices and bid/offers.
  * Keyed on product identifier.
@@ -110,19 +142,38 @@ class PricingConnector;
 template<typename T>
 class PricingService : public Service<string, Price<T>> {
 private:
-    map<string, Price<T>> priceData;
+    // The last propagated price of each product, in half ticks, is kept next to the latest price for the deadband check.
+    struct PriceEntry {
+        Price<T> price;
+        long long midHalfTicks = 0;
+        long long spreadHalfTicks = 0;
+        bool propagated = false;
+    };
+    map<string, PriceEntry, less<>> priceData;
     vector<ServiceListener<Price<T>>*> listeners;
     unique_ptr<PricingConnector<T>> connector;
+    bool deadbandEnabled = false;
+    long long midDeadband = 0;
+    long long spreadDeadband = 0;
+    long filteredCount = 0;
+    unique_ptr<CompositePricer<T>> compositePricer;
 
 public:
     PricingService();
     ~PricingService() = default;
 
     Price<T>& GetData(string key) override;
+    Price<T>* TryGet(string_view key) override;
+    Price<T>* Find(const T& product);
     void OnMessage(Price<T>& data) override;
     void AddListener(ServiceListener<Price<T>>* listener) override;
     const vector<ServiceListener<Price<T>>*>& GetListeners() const override;
     PricingConnector<T>* GetConnector();
+    void SetDeadband(long long midTicks, long long spreadTicks);
+    long GetFilteredCount() const;
+    void OnSourceMessage(const string& source, Price<T>& data);
+    void AttachCompositePricer(unique_ptr<CompositePricer<T>> pricer);
+    CompositePricer<T>* GetCompositePricer();
 };
 
 template<typename T>
@@ -130,27 +181,87 @@ PricingService<T>::PricingService() : connector(make_unique<PricingConnector<T>>
 
 template<typename T>
 Price<T>& PricingService<T>::GetData(string key) {
-    auto it = priceData.find(key);
-    if (it != priceData.end()) {
-        return it->second;
+    Price<T>* price = TryGet(key);
+    if (price == nullptr) {
+        throw runtime_error("Key not found: " + key);
     }
-    throw runtime_error("Key not found: " + key);
+    return *price;
+}
+
+template<typename T>
+Price<T>* PricingService<T>::TryGet(string_view key) {
+    auto it = priceData.find(key);
+    return it != priceData.end() ? &it->second.price : nullptr;
+}
+
+template<typename T>
+Price<T>* PricingService<T>::Find(const T& product) {
+    return TryGet(product.GetProductId());
 }
 
 template<typename T>
 void PricingService<T>::OnMessage(Price<T>& data) {
-    string key = data.GetProduct().GetProductId();
-    if (priceData.find(key) != priceData.end()) 
-    { 
-        priceData.erase(key); 
+    TRACE_MESSAGE("PricingService::OnMessage");
+    // Overwrite in place so a known product never reallocates its map node.
+    PriceEntry& entry = priceData.try_emplace(data.GetProduct().GetProductId()).first->second;
+    entry.price = data;
+
+    if (deadbandEnabled) {
+        const double halfTicksPerUnit = 2.0 / data.GetProduct().GetTickSize();
+        long long midHalfTicks = std::llround(data.GetMid() * halfTicksPerUnit);
+        long long spreadHalfTicks = std::llround(data.GetBidOfferSpread() * halfTicksPerUnit);
+        // Bands are whole ticks, i.e. two half ticks. Non-short-circuit operators keep the check free of
+        // data-dependent branches.
+        bool moved = !entry.propagated | (std::llabs(midHalfTicks - entry.midHalfTicks) > 2 * midDeadband)
+                     | (std::llabs(spreadHalfTicks - entry.spreadHalfTicks) > 2 * spreadDeadband);
+        if (!moved) {
+            ++filteredCount;
+            return;
+        }
+        entry.midHalfTicks = midHalfTicks;
+        entry.spreadHalfTicks = spreadHalfTicks;
+        entry.propagated = true;
     }
-    priceData.insert(pair<string, Price<Bond> >(key, data));
 
     for (auto& l : listeners) {
         l->ProcessAdd(data);
     }
 }
 
+template<typename T>
+void PricingService<T>::SetDeadband(long long midTicks, long long spreadTicks) {
+    deadbandEnabled = midTicks >= 0 && spreadTicks >= 0;
+    midDeadband = midTicks;
+    spreadDeadband = spreadTicks;
+}
+
+template<typename T>
+long PricingService<T>::GetFilteredCount() const {
+    return filteredCount;
+}
+
+template<typename T>
+void PricingService<T>::OnSourceMessage(const string& source, Price<T>& data) {
+    if (!compositePricer) {
+        OnMessage(data);
+        return;
+    }
+    Price<T> composite;
+    if (compositePricer->Update(source, data, composite)) {
+        OnMessage(composite);
+    }
+}
+
+template<typename T>
+void PricingService<T>::AttachCompositePricer(unique_ptr<CompositePricer<T>> pricer) {
+    compositePricer = std::move(pricer);
+}
+
+template<typename T>
+CompositePricer<T>* PricingService<T>::GetCompositePricer() {
+    return compositePricer.get();
+}
+
 template<typename T>
 void PricingService<T>::AddListener(ServiceListener<Price<T>>* listener) {
     listeners.push_back(listener);
@@ -174,6 +285,8 @@ template<typename T>
 class PricingConnector : public Connector<Price<T>> {
 private:
     PricingService<T>* service;
+    TimerWheel* timers = nullptr;
+    EventTimeClock* eventClock = nullptr;
 
 public:
     explicit PricingConnector(PricingService<T>* _service);
@@ -181,6 +294,12 @@ public:
 
     void Publish(Price<T>& data) override;
     void Subscribe(ifstream& _data);
+
+    // Fires due timers before each price is processed.
+    void AttachTimerWheel(TimerWheel* _timers) { timers = _timers; }
+
+    // Moves the clock to each row's timestamp before the row is processed.
+    void AttachEventClock(EventTimeClock* _eventClock) { eventClock = _eventClock; }
 };
 
 template<typename T>
@@ -198,6 +317,7 @@ void PricingConnector<T>::Subscribe(ifstream& _data) {
     getline(_data, line); // Skip the header
 
     while (getline(_data, line)) {
+        TRACE_MESSAGE("PricingConnector::Subscribe");
         stringstream rawline(line);
         vector<string> splitdata;
         string block;
@@ -206,6 +326,14 @@ void PricingConnector<T>::Subscribe(ifstream& _data) {
             splitdata.push_back(block);
         }
 
+        long long eventTime = TimeUtils::ParseTimeNanos(splitdata[0]);
+        if (eventClock != nullptr) {
+            eventClock->Advance(eventTime);
+        }
+        if (timers != nullptr) {
+            timers->Poll();
+        }
+
         string productID = splitdata[1];
         double bid = PriceUtils::Frac2Price(splitdata[2]);
         double ask = PriceUtils::Frac2Price(splitdata[3]);
@@ -214,9 +342,13 @@ void PricingConnector<T>::Subscribe(ifstream& _data) {
         double spread = ask - bid;
 
         T product = ProductFactory<T>::QueryProduct(productID);
-        Price<T> price(product, mid, spread);
+        Price<T> price(product, mid, spread, eventTime);
 
-        service->OnMessage(price);
+        if (splitdata.size() > 5) {
+            service->OnSourceMessage(splitdata[5], price);
+        } else {
+            service->OnSourceMessage(DEFAULT_PRICE_SOURCE, price);
+        }
     }
 }
 
@@ -66,6 +66,9 @@ public:
   // Get the bond identifier type
   BondIdType GetBondIdType() const;
 
+  // Get the minimum price increment; Treasuries are quoted in 1/256ths
+  double GetTickSize() const;
+
   // Print the bond
   friend ostream& operator<<(ostream &output, const Bond &bond);
 
@@ -183,7 +186,7 @@ Bond::Bond(string _productId, BondIdType _bondIdType, string _ticker, float _cou
   maturityDate =_maturityDate;
 }
 
-Bond::Bond() : Product(0, BOND)
+Bond::Bond() : Product("", BOND)
 {
 }
 
@@ -207,6 +210,11 @@ BondIdType Bond::GetBondIdType() const
   return bondIdType;
 }
 
+double Bond::GetTickSize() const
+{
+  return 1.0 / 256.0;
+}
+
 ostream& operator<<(ostream &output, const Bond &bond)
 {
   output << bond.ticker << " " << bond.coupon << " " << bond.GetMaturityDate();
@@ -231,7 +239,7 @@ IRSwap::IRSwap(string _productId, DayCountConvention _fixedLegDayCountConvention
   terminationDate =_terminationDate;
 }
 
-IRSwap::IRSwap() : Product(0, IRSWAP)
+IRSwap::IRSwap() : Product("", IRSWAP)
 {
 }
 
@@ -351,15 +351,24 @@
 //
 // @class RiskService
 // @description Manages PV01 risks, calculates bucketed risks, and integrates with position data.
+//              Each position change is applied as a delta against the stored quantity, which also moves the
+//              running totals of every registered sector holding the product, so a corrected trade updates
+//              product and bucketed risk in O(1). Corrections are published as ProcessUpdate.
+//              In coalescing mode a position event only marks its product dirty; risk is recomputed and published
+//              once per dirty product when a batch fills up, when a time slice on the timer wheel ends, or on an
+//              explicit Flush. Risk is exact at every flush, and a burst of fills in one CUSIP costs one update.
 //
 // @class RiskServiceListener
 // @description Links the PositionService with the RiskService, enabling automatic updates to PV01 data.
+//              Position adds and corrections (ProcessUpdate) are both forwarded.
 //
 // @methods (PV01)
 // - GetProduct: Retrieves the associated product.
 // - GetPV01: Returns the PV01 value.
 // - GetQuantity: Returns the total quantity.
 // - UpdateQuantity: Updates the quantity by adding the provided value.
+// - SetQuantity: Replaces the quantity.
+// - GetEventTime / SetEventTime: Event time of the position update behind the risk, in nanoseconds since the epoch.
 // - operator<<: Outputs a formatted representation of the PV01 object.
 //
 // @methods (BucketedSector)
@@ -368,15 +377,24 @@
 //
 // @methods (RiskService)
 // - GetData: Retrieves PV01 data for a specific product.
+// - TryGet: Retrieves PV01 data for a product identifier, or nullptr if none exists.
+// - Find: Retrieves PV01 data for a product, or nullptr if none exists.
 // - OnMessage: Placeholder for handling inbound PV01 messages.
 // - AddListener: Registers a listener for PV01 updates.
 // - GetListeners: Retrieves all registered listeners.
 // - GetRiskServiceListener: Returns the associated risk service listener.
 // - AddPosition: Updates PV01 data using position information.
-// - GetBucketedRisk: Calculates the aggregated PV01 for a bucketed sector.
+// - UpdatePosition: Applies a corrected position and publishes the change as an update.
+// - RegisterSector: Keeps running totals for a sector so its bucketed risk is read in O(1).
+// - EnableCoalescing: Batches position events, flushing after a number of events (0 for no limit) or a time slice,
+//                     or both. A batch of 1 turns coalescing off.
+// - Flush: Recomputes and publishes the risk of every dirty product.
+// - GetDirtyCount: Returns the number of products waiting for the next flush.
+// - GetBucketedRisk: Returns the aggregated PV01 for a bucketed sector, from running totals when registered.
 //
 // @methods (RiskServiceListener)
 // - ProcessAdd: Processes new position data to update PV01 risks.
+// - ProcessUpdate: Processes corrected position data to update PV01 risks.
 //
 // @date 2024-12-20
 // @version 1.1
@@ -391,7 +409,10 @@
 #include "soa.hpp"
 #include "positionservice.hpp"
 #include "BondAnalytics.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
 #include <numeric>
+#include <unordered_set>
 
 /**
  * PV01 risk.
@@ -401,13 +422,16 @@ template<typename T>
 class PV01 {
 public:
     PV01() = default;
-    PV01(const T& _product, double _pv01, long _quantity);
+    PV01(const T& _product, double _pv01, long _quantity, long long _eventTime = 0);
     ~PV01() = default;
 
     const T& GetProduct() const;
     double GetPV01() const;
     long GetQuantity() const;
     void UpdateQuantity(long _quantity);
+    void SetQuantity(long _quantity);
+    long long GetEventTime() const;
+    void SetEventTime(long long _eventTime);
 
     template<typename S>
     friend ostream& operator<<(ostream& os, const PV01<S>& pv01);
@@ -416,11 +440,12 @@ private:
     T product;
     double pv01;
     long quantity;
+    long long eventTime = 0;
 };
 
 template<typename T>
-PV01<T>::PV01(const T& _product, double _pv01, long _quantity)
-    : product(_product), pv01(_pv01), quantity(_quantity) {}
+PV01<T>::PV01(const T& _product, double _pv01, long _quantity, long long _eventTime)
+    : product(_product), pv01(_pv01), quantity(_quantity), eventTime(_eventTime) {}
 
 template<typename T>
 const T& PV01<T>::GetProduct() const {
@@ -442,6 +467,21 @@ void PV01<T>::UpdateQuantity(long _quantity) {
     quantity += _quantity;
 }
 
+template<typename T>
+void PV01<T>::SetQuantity(long _quantity) {
+    quantity = _quantity;
+}
+
+template<typename T>
+long long PV01<T>::GetEventTime() const {
+    return eventTime;
+}
+
+template<typename T>
+void PV01<T>::SetEventTime(long long _eventTime) {
+    eventTime = _eventTime;
+}
+
 template<typename T>
 ostream& operator<<(ostream& os, const PV01<T>& pv01) {
     os << pv01.product.GetProductId() << "," << pv01.pv01 << "," << pv01.quantity;
@@ -488,36 +528,87 @@ template<typename T>
 class RiskService : public Service<string, PV01<T>> {
 private:
     vector<ServiceListener<PV01<T>>*> listeners;
-    map<string, PV01<T>> pv01Data;
+    map<string, PV01<T>, less<>> pv01Data;
     unique_ptr<RiskServiceListener<T>> riskServiceListener;
 
+    // Running totals of a registered sector, moved by every position delta of its products.
+    struct SectorTotals {
+        BucketedSector<T> sector;
+        double pv01;
+        long quantity;
+    };
+    vector<SectorTotals> sectorTotals;
+    map<string, size_t, less<>> sectorIndex;
+    map<string, vector<size_t>, less<>> productSectors;
+
+    // Coalescing state: positions are owned by PositionService, whose map keeps them at stable addresses.
+    struct DirtyPosition {
+        Position<T>* position;
+        bool added;
+    };
+    bool coalescing = false;
+    size_t maxBatch = 0;
+    size_t pendingEvents = 0;
+    vector<DirtyPosition> dirty;
+    unordered_set<const Position<T>*> dirtySet;
+    TimerWheel* sliceTimers = nullptr;
+    TimerId sliceTimer = INVALID_TIMER;
+
     double CalculateSectorPV01(const vector<T>& products, long& totalQuantity) const;
+    PV01<T>& ApplyPosition(Position<T>& position);
+    void MarkDirty(Position<T>& position, bool added);
 
 public:
     RiskService();
-    ~RiskService() = default;
+    ~RiskService();
 
     PV01<T>& GetData(string key) override;
+    PV01<T>* TryGet(string_view key) override;
+    PV01<T>* Find(const T& product);
     void OnMessage(PV01<T>& data) override;
     void AddListener(ServiceListener<PV01<T>>* listener) override;
     const vector<ServiceListener<PV01<T>>*>& GetListeners() const override;
 
     RiskServiceListener<T>* GetRiskServiceListener();
     void AddPosition(Position<T>& position);
+    void UpdatePosition(Position<T>& position);
+    void RegisterSector(const BucketedSector<T>& sector);
     PV01<BucketedSector<T>> GetBucketedRisk(const BucketedSector<T>& sector) const;
+
+    void EnableCoalescing(size_t _maxBatch, TimerWheel* timers = nullptr, long long sliceNanos = 0);
+    void Flush();
+    size_t GetDirtyCount() const;
 };
 
 template<typename T>
 RiskService<T>::RiskService()
     : riskServiceListener(make_unique<RiskServiceListener<T>>(this)) {}
 
+template<typename T>
+RiskService<T>::~RiskService() {
+    if (sliceTimers != nullptr) {
+        sliceTimers->Cancel(sliceTimer);
+    }
+}
+
 template<typename T>
 PV01<T>& RiskService<T>::GetData(string key) {
-    auto it = pv01Data.find(key);
-    if (it != pv01Data.end()) {
-        return it->second;
+    PV01<T>* pv01 = TryGet(key);
+    if (pv01 == nullptr) {
+        throw runtime_error("Key not found: " + key);
     }
-    throw runtime_error("Key not found: " + key);
+    return *pv01;
+}
+
+template<typename T>
+PV01<T>* RiskService<T>::TryGet(string_view key) {
+    auto it = pv01Data.find(key);
+    return it != pv01Data.end() ? &it->second : nullptr;
+}
+
+template<typename T>
+PV01<T>* RiskService<T>::Find(const T& product) {
+    return TryGet(product.GetProductId());
 }
 
 template<typename T>
@@ -542,26 +633,137 @@ RiskServiceListener<T>* RiskService<T>::GetRiskServiceListener() {
 
 template<typename T>
 void RiskService<T>::AddPosition(Position<T>& position) {
+    TRACE_SPAN("RiskService::AddPosition");
+    if (coalescing) {
+        MarkDirty(position, true);
+        return;
+    }
+    PV01<T>& pv01 = ApplyPosition(position);
+    for (auto* listener : listeners) {
+        listener->ProcessAdd(pv01);
+    }
+}
+
+template<typename T>
+void RiskService<T>::UpdatePosition(Position<T>& position) {
+    TRACE_SPAN("RiskService::UpdatePosition");
+    if (coalescing) {
+        MarkDirty(position, false);
+        return;
+    }
+    PV01<T>& pv01 = ApplyPosition(position);
+    for (auto* listener : listeners) {
+        listener->ProcessUpdate(pv01);
+    }
+}
+
+template<typename T>
+PV01<T>& RiskService<T>::ApplyPosition(Position<T>& position) {
     const auto& product = position.GetProduct();
-    string productId = product.GetProductId();
+    const string& productId = product.GetProductId();
     long quantity = position.GetAggregatePosition();
-    double pv01Value = BondAnalytics::QueryPV01(productId);
 
-    PV01<T> pv01(product, pv01Value, quantity);
-    if (pv01Data.find(productId) != pv01Data.end()){
-      pv01Data[productId].UpdateQuantity(quantity);
-    }else{
-      pv01Data.insert(pair<string, PV01<T>>(productId, pv01));
+    auto it = pv01Data.find(productId);
+    if (it == pv01Data.end()) {
+        double pv01Value = BondAnalytics::QueryPV01(productId);
+        it = pv01Data.emplace(productId, PV01<T>(product, pv01Value, 0)).first;
     }
+    PV01<T>& pv01 = it->second;
+    long delta = quantity - pv01.GetQuantity();
+    pv01.SetQuantity(quantity);
+    pv01.SetEventTime(position.GetEventTime());
+
+    auto sectors = productSectors.find(productId);
+    if (sectors != productSectors.end()) {
+        for (size_t index : sectors->second) {
+            sectorTotals[index].pv01 += pv01.GetPV01() * delta;
+            sectorTotals[index].quantity += delta;
+        }
+    }
+    return pv01;
+}
 
+template<typename T>
+void RiskService<T>::MarkDirty(Position<T>& position, bool added) {
+    if (dirtySet.insert(&position).second) {
+        dirty.push_back(DirtyPosition{&position, added});
+    } else if (added) {
+        for (auto& entry : dirty) {
+            if (entry.position == &position) entry.added = true;
+        }
+    }
+    if (maxBatch > 0 && ++pendingEvents >= maxBatch) {
+        Flush();
+    }
+}
 
-    for (auto* listener : listeners) {
-        listener->ProcessAdd(pv01);
+template<typename T>
+void RiskService<T>::EnableCoalescing(size_t _maxBatch, TimerWheel* timers, long long sliceNanos) {
+    Flush();
+    if (sliceTimers != nullptr) {
+        sliceTimers->Cancel(sliceTimer);
+        sliceTimers = nullptr;
+    }
+    maxBatch = _maxBatch;
+    coalescing = maxBatch != 1;
+    if (coalescing && timers != nullptr && sliceNanos > 0) {
+        sliceTimers = timers;
+        sliceTimer = timers->SchedulePeriodic(sliceNanos, [this]() { Flush(); });
+    }
+}
+
+template<typename T>
+void RiskService<T>::Flush() {
+    TRACE_SPAN("RiskService::Flush");
+    // Swap the batch out first, so a listener that feeds positions back in starts the next batch cleanly.
+    vector<DirtyPosition> batch;
+    batch.swap(dirty);
+    dirtySet.clear();
+    pendingEvents = 0;
+    for (const DirtyPosition& entry : batch) {
+        PV01<T>& pv01 = ApplyPosition(*entry.position);
+        for (auto* listener : listeners) {
+            if (entry.added) {
+                listener->ProcessAdd(pv01);
+            } else {
+                listener->ProcessUpdate(pv01);
+            }
+        }
+    }
+    if (dirty.empty()) {
+        // Keep the allocation for the next batch.
+        batch.clear();
+        dirty.swap(batch);
+    }
+}
+
+template<typename T>
+size_t RiskService<T>::GetDirtyCount() const {
+    return dirty.size();
+}
+
+template<typename T>
+void RiskService<T>::RegisterSector(const BucketedSector<T>& sector) {
+    if (sectorIndex.count(sector.GetName()) > 0) {
+        return;
+    }
+    long quantity = 0;
+    double pv01 = CalculateSectorPV01(sector.GetProducts(), quantity);
+    size_t index = sectorTotals.size();
+    sectorTotals.push_back(SectorTotals{sector, pv01, quantity});
+    sectorIndex.emplace(sector.GetName(), index);
+    for (const T& product : sector.GetProducts()) {
+        productSectors[product.GetProductId()].push_back(index);
     }
 }
 
 template<typename T>
 PV01<BucketedSector<T>> RiskService<T>::GetBucketedRisk(const BucketedSector<T>& sector) const {
+    auto registered = sectorIndex.find(sector.GetName());
+    if (registered != sectorIndex.end()) {
+        const SectorTotals& totals = sectorTotals[registered->second];
+        return PV01<BucketedSector<T>>(totals.sector, totals.pv01, totals.quantity);
+    }
     long totalQuantity = 0;
     double totalPV01 = CalculateSectorPV01(sector.GetProducts(), totalQuantity);
     return PV01<BucketedSector<T>>(sector, totalPV01, totalQuantity);
@@ -593,7 +795,7 @@ public:
     explicit RiskServiceListener(RiskService<T>* service);
     void ProcessAdd(Position<T>& data) override;
     void ProcessRemove(Position<T>& data) override {}
-    void ProcessUpdate(Position<T>& data) override {}
+    void ProcessUpdate(Position<T>& data) override;
 };
 
 template<typename T>
@@ -604,4 +806,9 @@ void RiskServiceListener<T>::ProcessAdd(Position<T>& data) {
     riskService->AddPosition(data);
 }
 
+template<typename T>
+void RiskServiceListener<T>::ProcessUpdate(Position<T>& data) {
+    riskService->UpdatePosition(data);
+}
+
 #endif
@@ -9,6 +9,7 @@
 #define SOA_HPP
 
 #include <vector>
+#include <string_view>
 
 using namespace std;
 
@@ -23,6 +24,8 @@ class ServiceListener
 
 public:
 
+  virtual ~ServiceListener() = default;
+
   // Listener callback to process an add event to the Service
   virtual void ProcessAdd(V &data) = 0;
 
@@ -47,6 +50,10 @@ public:
   // Get data on our service given a key
   virtual V& GetData(K key) = 0;
 
+  // Get data on our service given a key, or nullptr if the key is unknown.
+  // Unlike GetData this never throws, so it is the lookup to use on hot paths.
+  virtual V* TryGet(std::string_view key) = 0;
+
   // The callback that a Connector should invoke for any new or updated data
   virtual void OnMessage(V &data) = 0;
 
@@ -73,6 +80,8 @@ class Connector
 
 public:
 
+  virtual ~Connector() = default;
+
   // Publish data to the Connector
   virtual void Publish(V &data) = 0;
 
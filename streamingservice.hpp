@@ -14,16 +14,20 @@
 //
 // @methods (StreamingService)
 // - GetData: Retrieves a price stream by its product identifier.
+// - TryGet: Retrieves a price stream by its product identifier, or nullptr if none exists.
+// - Find: Retrieves the price stream for a product, or nullptr if none exists.
 // - OnMessage: Placeholder for handling incoming messages (not implemented).
 // - AddListener: Registers a listener for updates.
 // - GetListeners: Retrieves all registered listeners.
 // - GetStreamingServiceListener: Provides access to the service listener.
 // - GetConnector: Provides access to the associated connector.
 // - PublishPrice: Publishes a price stream using the connector.
+//   Client-facing tiered quotes are published by StreamingGateway, registered as a listener.
 // - AddPriceStream: Adds or updates a price stream and notifies listeners.
 //
 // @methods (StreamingServiceConnector)
-// - Publish: Outputs a formatted representation of the price stream to the console.
+// - Publish: Outputs a formatted representation of the price stream to the console, or its binary wire encoding.
+// - SetOutput: Selects text or binary wire output and the stream it is written to.
 //
 // @methods (StreamingServiceListener)
 // - ProcessAdd: Forwards algorithmic stream data to the streaming service for processing and publication.
@@ -41,6 +45,8 @@
 #include "soa.hpp"
 #include "PriceStream.hpp"
 #include "AlgoStream.hpp"
+#include "TraceRecorder.hpp"
+#include "WireCodec.hpp"
 
 template<typename T>
 class StreamingServiceConnector;
@@ -52,9 +58,11 @@ template<typename T>
 class StreamingService : public Service<std::string, PriceStream<T>> {
 public:
     StreamingService();
-    ~StreamingService() = default;
+    ~StreamingService();
 
     PriceStream<T>& GetData(std::string key) override;
+    PriceStream<T>* TryGet(std::string_view key) override;
+    PriceStream<T>* Find(const T& product);
     void OnMessage(PriceStream<T>& data) override {}
     void AddListener(ServiceListener<PriceStream<T>>* listener) override;
     const std::vector<ServiceListener<PriceStream<T>>*>& GetListeners() const override;
@@ -66,7 +74,7 @@ public:
     void AddPriceStream(const AlgoStream<T>& algoStream);
 
 private:
-    std::map<std::string, PriceStream<T>> priceStreamData;
+    std::map<std::string, PriceStream<T>, std::less<>> priceStreamData;
     std::vector<ServiceListener<PriceStream<T>>*> listeners;
     StreamingServiceConnector<T>* connector;
     StreamingServiceListener<T>* streamingServiceListener;
@@ -74,15 +82,33 @@ private:
 
 template<typename T>
 StreamingService<T>::StreamingService()
-    : streamingServiceListener(new StreamingServiceListener<T>(this)) {}
+    : connector(new StreamingServiceConnector<T>(this)),
+      streamingServiceListener(new StreamingServiceListener<T>(this)) {}
+
+template<typename T>
+StreamingService<T>::~StreamingService() {
+    delete connector;
+    delete streamingServiceListener;
+}
 
 template<typename T>
 PriceStream<T>& StreamingService<T>::GetData(std::string key) {
-    auto it = priceStreamData.find(key);
-    if (it == priceStreamData.end()) {
+    PriceStream<T>* priceStream = TryGet(key);
+    if (priceStream == nullptr) {
         throw std::runtime_error("Key not found");
     }
-    return it->second;
+    return *priceStream;
+}
+
+template<typename T>
+PriceStream<T>* StreamingService<T>::TryGet(std::string_view key) {
+    auto it = priceStreamData.find(key);
+    return it != priceStreamData.end() ? &it->second : nullptr;
+}
+
+template<typename T>
+PriceStream<T>* StreamingService<T>::Find(const T& product) {
+    return TryGet(product.GetProductId());
 }
 
 template<typename T>
@@ -107,22 +133,16 @@ StreamingServiceConnector<T>* StreamingService<T>::GetConnector() {
 
 template<typename T>
 void StreamingService<T>::PublishPrice(const PriceStream<T>& priceStream) {
-    // if (connector) {
-    //     connector->Publish(priceStream);
-    // }
+    TRACE_SPAN("StreamingService::PublishPrice");
     connector->Publish(priceStream);
 }
 
 template<typename T>
 void StreamingService<T>::AddPriceStream(const AlgoStream<T>& algoStream) {
+    TRACE_SPAN("StreamingService::AddPriceStream");
     PriceStream<T> priceStream = algoStream.GetPriceStream();
-    string key = priceStream.GetProduct().GetProductId();
     // update the price stream map
-    if (priceStreamData.find(key) != priceStreamData.end()) 
-    {
-        priceStreamData.erase(key);
-    }
-    priceStreamData.insert(pair<string, PriceStream<T> > (key, priceStream));
+    priceStreamData.insert_or_assign(priceStream.GetProduct().GetProductId(), priceStream);
 
     // flow the data to listeners
     for (auto& l : listeners) {
@@ -136,24 +156,42 @@ public:
     explicit StreamingServiceConnector(StreamingService<T>* service);
     ~StreamingServiceConnector() = default;
 
+    void Publish(PriceStream<T>& data) override { Publish(static_cast<const PriceStream<T>&>(data)); }
     void Publish(const PriceStream<T>& data);
+    void SetOutput(WireFormat _format, std::ostream& _output = std::cout);
 
 private:
     StreamingService<T>* service;
+    WireFormat format = TEXT_FORMAT;
+    std::ostream* output = &std::cout;
+    PriceStreamEncoder encoder;
+    char buffer[PriceStreamEncoder::ENCODED_LENGTH];
 };
 
 template<typename T>
 StreamingServiceConnector<T>::StreamingServiceConnector(StreamingService<T>* service)
     : service(service) {}
 
+template<typename T>
+void StreamingServiceConnector<T>::SetOutput(WireFormat _format, std::ostream& _output) {
+    format = _format;
+    output = &_output;
+}
+
 template<typename T>
 void StreamingServiceConnector<T>::Publish(const PriceStream<T>& data) {
+    if (format == BINARY_FORMAT) {
+        std::size_t length = encoder.Wrap(buffer, sizeof(buffer)).Encode(data);
+        output->write(buffer, static_cast<std::streamsize>(length));
+        return;
+    }
+
     const auto& product = data.GetProduct();
     const auto& productId = product.GetProductId();
     const auto& bid = data.GetBidOrder();
     const auto& offer = data.GetOfferOrder();
 
-    std::cout << "Price Stream (Product " << productId << "):\n"
+    *output << "Price Stream (Product " << productId << "):\n"
               << "\tBid\tPrice: " << bid.GetPrice()
               << "\tVisibleQuantity: " << bid.GetVisibleQuantity()
               << "\tHiddenQuantity: " << bid.GetHiddenQuantity() << "\n"
@@ -4,9 +4,18 @@
 //
 // @class Trade
 // @description Represents a trade with attributes such as product, trade ID, price, book, quantity, and side.
+//              An amended trade also carries the book and signed quantity of the version it replaces, so
+//              downstream services can reverse the original in O(1) without looking it up.
 //
 // @class TradeBookingService
 // @description Manages a collection of trades, allowing booking and notifying listeners of updates.
+//              Inbound trades pass through a TradeDeduplicator, so a trade id seen within the deduplication window
+//              is dropped instead of being booked twice. Booked trades are kept for a separate correction window
+//              (in event time, with a capacity cap) so they can be amended or cancelled; a cancelled trade stays
+//              as a tombstone until it leaves that window. An id still in the store is a duplicate even after the
+//              deduplicator forgets it, and a trade no newer than the last one evicted from the store is rejected
+//              as stale, so no id is ever booked twice and the store stays bounded. Corrections are published as
+//              ProcessUpdate (amend) and ProcessRemove (cancel) with the affected trade.
 //
 // @class TradeBookingConnector
 // @description Handles inbound connections for subscribing to trade data.
@@ -21,19 +30,35 @@
 // - GetBook: Returns the book to which the trade belongs.
 // - GetQuantity: Returns the trade quantity.
 // - GetSide: Returns the trade side (BUY or SELL).
+// - GetEventTime: Returns the event time of the trade in nanoseconds since the epoch, or 0 when unknown.
+// - GetSignedQuantity: Returns the position change of the trade, positive for BUY and negative for SELL.
+// - SetEventTime: Sets the event time, e.g. to the time of the correction that cancels the trade.
+// - SetOriginal: Marks the trade as an amendment of an earlier version.
+// - IsAmendment / GetOriginalBook / GetOriginalSignedQuantity: Describe the version an amendment replaces.
 //
 // @methods (TradeBookingService)
 // - GetData: Retrieves a trade by its trade ID.
-// - OnMessage: Handles new or updated trade data.
+// - TryGet: Retrieves a trade by its trade ID, or nullptr if none exists.
+// - OnMessage: Stores and publishes a new trade; duplicates of a remembered trade id are ignored.
 // - AddListener: Registers a listener for trade updates.
 // - GetListeners: Retrieves all registered listeners.
 // - GetConnector: Provides access to the associated connector.
 // - GetTradeBookingServiceListener: Provides access to the trade booking listener.
-// - BookTrade: Books a trade and notifies listeners.
+// - BookTrade: Stores a trade booked from an execution and notifies listeners.
+// - ConfigureDeduplication: Sets the event-time window and per-generation capacity of the duplicate check.
+// - ConfigureCorrections: Sets the event-time window and capacity for which booked trades can be corrected.
+// - GetDuplicateCount: Returns the number of duplicate trades ignored.
+// - GetStaleCount: Returns the number of trades rejected as older than the correction window.
+// - AmendTrade: Replaces a booked trade and publishes the amendment; returns false if the trade is unknown.
+// - CancelTrade: Removes a booked trade and publishes the cancellation, stamped with the cancel's event time when
+//                one is given; returns false if the trade is unknown.
 //
 // @methods (TradeBookingConnector)
 // - Publish: No-op for this inbound-only connector.
-// - Subscribe: Reads trade data from an input stream and adds it to the service.
+// - Subscribe: Reads trade data from an input stream and adds it to the service. An optional seventh column
+//              holds the event time and an optional eighth column the action: NEW (default), AMEND or CANCEL.
+// - AttachTimerWheel: Drives a timer wheel from the trade feed.
+// - AttachEventClock: Advances an event-time clock to the timestamp of each trade.
 //
 // @methods (TradeBookingServiceListener)
 // - ProcessAdd: Converts `ExecutionOrder` data to `Trade` data and books the trade.
@@ -48,11 +73,19 @@
 #ifndef TRADE_BOOKING_SERVICE_HPP
 #define TRADE_BOOKING_SERVICE_HPP
 
+#include <algorithm>
+#include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
 #include <map>
 #include "soa.hpp"
 #include "executionservice.hpp"
+#include "TraceRecorder.hpp"
+#include "TimerWheel.hpp"
+#include "TimeUtils.hpp"
+#include "TradeDeduplicator.hpp"
 
 // Trade sides
 enum Side { BUY, SELL };
@@ -65,7 +98,8 @@ template<typename T>
 class Trade {
 public:
     Trade() = default;
-    Trade(const T& _product, const std::string& _tradeId, double _price, const std::string& _book, long _quantity, Side _side);
+    Trade(const T& _product, const std::string& _tradeId, double _price, const std::string& _book, long _quantity, Side _side,
+          long long _eventTime = 0);
     ~Trade() = default;
 
     const T& GetProduct() const;
@@ -74,6 +108,14 @@ public:
     const std::string& GetBook() const;
     long GetQuantity() const;
     Side GetSide() const;
+    long long GetEventTime() const;
+    long GetSignedQuantity() const;
+    void SetEventTime(long long _eventTime);
+
+    void SetOriginal(const Trade<T>& original);
+    bool IsAmendment() const;
+    const std::string& GetOriginalBook() const;
+    long GetOriginalSignedQuantity() const;
 
 private:
     T product;
@@ -82,11 +124,16 @@ private:
     std::string book;
     long quantity;
     Side side;
+    long long eventTime = 0;
+    bool amendment = false;
+    std::string originalBook;
+    long originalSignedQuantity = 0;
 };
 
 template<typename T>
-Trade<T>::Trade(const T& _product, const std::string& _tradeId, double _price, const std::string& _book, long _quantity, Side _side)
-    : product(_product), tradeId(_tradeId), price(_price), book(_book), quantity(_quantity), side(_side) {}
+Trade<T>::Trade(const T& _product, const std::string& _tradeId, double _price, const std::string& _book, long _quantity, Side _side,
+                long long _eventTime)
+    : product(_product), tradeId(_tradeId), price(_price), book(_book), quantity(_quantity), side(_side), eventTime(_eventTime) {}
 
 template<typename T>
 const T& Trade<T>::GetProduct() const { return product; }
@@ -106,6 +153,31 @@ long Trade<T>::GetQuantity() const { return quantity; }
 template<typename T>
 Side Trade<T>::GetSide() const { return side; }
 
+template<typename T>
+long long Trade<T>::GetEventTime() const { return eventTime; }
+
+template<typename T>
+long Trade<T>::GetSignedQuantity() const { return side == BUY ? quantity : -quantity; }
+
+template<typename T>
+void Trade<T>::SetEventTime(long long _eventTime) { eventTime = _eventTime; }
+
+template<typename T>
+void Trade<T>::SetOriginal(const Trade<T>& original) {
+    amendment = true;
+    originalBook = original.GetBook();
+    originalSignedQuantity = original.GetSignedQuantity();
+}
+
+template<typename T>
+bool Trade<T>::IsAmendment() const { return amendment; }
+
+template<typename T>
+const std::string& Trade<T>::GetOriginalBook() const { return originalBook; }
+
+template<typename T>
+long Trade<T>::GetOriginalSignedQuantity() const { return originalSignedQuantity; }
+
 // Forward declaration
 template<typename T>
 class TradeBookingConnector;
@@ -125,6 +197,7 @@ public:
     ~TradeBookingService() = default;
 
     Trade<T>& GetData(std::string key) override;
+    Trade<T>* TryGet(std::string_view key) override;
     void OnMessage(Trade<T>& data) override;
     void AddListener(ServiceListener<Trade<T>>* listener) override;
     const std::vector<ServiceListener<Trade<T>>*>& GetListeners() const override;
@@ -133,9 +206,34 @@ public:
     TradeBookingServiceListener<T>* GetTradeBookingServiceListener();
 
     void BookTrade(Trade<T>& trade);
+    void ConfigureDeduplication(long long windowNanos, std::size_t capacity);
+    void ConfigureCorrections(long long windowNanos, std::size_t capacity);
+    long GetDuplicateCount() const;
+    long GetStaleCount() const;
+    bool AmendTrade(Trade<T>& amended);
+    bool CancelTrade(std::string_view tradeId, long long eventTime = 0);
 
 private:
-    std::map<std::string, Trade<T>> tradeData;
+    // A booked trade and the event time it was booked at; live is false once the trade is cancelled.
+    struct BookedTrade {
+        Trade<T> trade;
+        long long bookedAt;
+        bool live;
+    };
+    using TradeStore = std::map<std::string, BookedTrade, std::less<>>;
+
+    void Store(const Trade<T>& trade);
+    void EvictCorrections(long long eventTime);
+
+    TradeStore tradeData;
+    std::deque<typename TradeStore::iterator> bookingOrder;
+    long long correctionWindowNanos = 24LL * 3600 * 1000000000LL;
+    std::size_t correctionCapacity = 1 << 20;
+    long long latestEventTime = 0;
+    long long evictedThrough = 0;
+    long storedDuplicates = 0;
+    long staleCount = 0;
+    TradeDeduplicator deduplicator;
     std::vector<ServiceListener<Trade<T>>*> listeners;
     TradeBookingConnector<T>* connector;
     TradeBookingServiceListener<T>* tradeBookingListener;
@@ -149,20 +247,35 @@ TradeBookingService<T>::TradeBookingService() {
 
 template<typename T>
 Trade<T>& TradeBookingService<T>::GetData(std::string key) {
-    auto it = tradeData.find(key);
-    if (it == tradeData.end()) {
+    Trade<T>* trade = TryGet(key);
+    if (trade == nullptr) {
         throw std::runtime_error("Key not found");
     }
-    return it->second;
+    return *trade;
+}
+
+template<typename T>
+Trade<T>* TradeBookingService<T>::TryGet(std::string_view key) {
+    auto it = tradeData.find(key);
+    return it != tradeData.end() && it->second.live ? &it->second.trade : nullptr;
 }
 
 template<typename T>
 void TradeBookingService<T>::OnMessage(Trade<T>& data) {
-    string key = data.GetTradeId();
-    if (tradeData.find(key) != tradeData.end())
-      tradeData[key] = data;
-    else
-      tradeData.insert(pair<string, Trade<T>>(key, data));
+    TRACE_MESSAGE("TradeBookingService::OnMessage");
+    // The store is checked first: it outlives the deduplicator's window, including cancelled trades.
+    if (tradeData.find(data.GetTradeId()) != tradeData.end()) {
+        ++storedDuplicates;
+        return;
+    }
+    if (data.GetEventTime() != 0 && data.GetEventTime() <= evictedThrough) {
+        ++staleCount;
+        return;
+    }
+    if (!deduplicator.Admit(data.GetTradeId(), data.GetEventTime())) {
+        return;
+    }
+    Store(data);
 
     for(auto& listener : listeners)
       listener->ProcessAdd(data);
@@ -190,11 +303,111 @@ TradeBookingServiceListener<T>* TradeBookingService<T>::GetTradeBookingServiceLi
 
 template<typename T>
 void TradeBookingService<T>::BookTrade(Trade<T>& trade) {
+    TRACE_SPAN("TradeBookingService::BookTrade");
+    // Stored like inbound trades so fills can be amended or cancelled too.
+    Store(trade);
     for (auto* listener : listeners) {
         listener->ProcessAdd(trade);
     }
 }
 
+template<typename T>
+void TradeBookingService<T>::ConfigureDeduplication(long long windowNanos, std::size_t capacity) {
+    // Ids remembered so far are forgotten; call this before any trade arrives.
+    deduplicator = TradeDeduplicator(windowNanos, capacity);
+}
+
+template<typename T>
+void TradeBookingService<T>::ConfigureCorrections(long long windowNanos, std::size_t capacity) {
+    if (windowNanos <= 0 || capacity == 0) {
+        throw std::invalid_argument("Correction window and capacity must be positive");
+    }
+    correctionWindowNanos = windowNanos;
+    correctionCapacity = capacity;
+    EvictCorrections(latestEventTime);
+}
+
+template<typename T>
+long TradeBookingService<T>::GetDuplicateCount() const {
+    return deduplicator.GetDuplicateCount() + storedDuplicates;
+}
+
+template<typename T>
+long TradeBookingService<T>::GetStaleCount() const {
+    return staleCount;
+}
+
+template<typename T>
+void TradeBookingService<T>::Store(const Trade<T>& trade) {
+    auto [it, inserted] = tradeData.insert_or_assign(trade.GetTradeId(), BookedTrade{ trade, trade.GetEventTime(), true });
+    if (inserted) {
+        bookingOrder.push_back(it);
+    }
+    EvictCorrections(trade.GetEventTime());
+}
+
+template<typename T>
+void TradeBookingService<T>::EvictCorrections(long long eventTime) {
+    latestEventTime = std::max(latestEventTime, eventTime);
+    // Trades are evicted in booking order; those without an event time only leave by capacity.
+    while (!bookingOrder.empty()) {
+        auto it = bookingOrder.front();
+        long long bookedAt = it->second.bookedAt;
+        bool expired = bookedAt != 0 && latestEventTime - bookedAt > correctionWindowNanos;
+        if (!expired && bookingOrder.size() <= correctionCapacity) {
+            break;
+        }
+        evictedThrough = std::max(evictedThrough, bookedAt);
+        tradeData.erase(it);
+        bookingOrder.pop_front();
+    }
+}
+
+template<typename T>
+bool TradeBookingService<T>::AmendTrade(Trade<T>& amended) {
+    TRACE_SPAN("TradeBookingService::AmendTrade");
+    auto it = tradeData.find(amended.GetTradeId());
+    if (it == tradeData.end() || !it->second.live) {
+        return false;
+    }
+    if (it->second.trade.GetProduct().GetProductId() != amended.GetProduct().GetProductId()) {
+        // A change of product is a cancel of the old position and a new trade in the other product.
+        CancelTrade(amended.GetTradeId(), amended.GetEventTime());
+        it->second.trade = amended;
+        it->second.live = true;
+        for (auto* listener : listeners) {
+            listener->ProcessAdd(amended);
+        }
+        return true;
+    }
+
+    amended.SetOriginal(it->second.trade);
+    it->second.trade = amended;
+    for (auto* listener : listeners) {
+        listener->ProcessUpdate(amended);
+    }
+    return true;
+}
+
+template<typename T>
+bool TradeBookingService<T>::CancelTrade(std::string_view tradeId, long long eventTime) {
+    TRACE_SPAN("TradeBookingService::CancelTrade");
+    auto it = tradeData.find(tradeId);
+    if (it == tradeData.end() || !it->second.live) {
+        return false;
+    }
+    // The cancelled trade stays as a tombstone until it leaves the correction window, so a replayed copy is
+    // caught as a duplicate; once evicted, a replay is no newer than evictedThrough and is rejected as stale.
+    it->second.live = false;
+    if (eventTime != 0) {
+        it->second.trade.SetEventTime(eventTime);
+    }
+    for (auto* listener : listeners) {
+        listener->ProcessRemove(it->second.trade);
+    }
+    return true;
+}
+
 /**
  * Connector that subscribes data from socket to trade booking service.
  * Type T is the product type.
@@ -208,8 +421,16 @@ public:
     void Publish(Trade<T>& data) override;
     void Subscribe(std::ifstream& data);
 
+    // Fires due timers before each trade is processed.
+    void AttachTimerWheel(TimerWheel* _timers) { timers = _timers; }
+
+    // Moves the clock to each row's timestamp before the row is processed.
+    void AttachEventClock(EventTimeClock* _eventClock) { eventClock = _eventClock; }
+
 private:
     TradeBookingService<T>* service;
+    TimerWheel* timers = nullptr;
+    EventTimeClock* eventClock = nullptr;
 };
 
 template<typename T>
@@ -222,6 +443,7 @@ template<typename T>
 void TradeBookingConnector<T>::Subscribe(std::ifstream& data) {
     std::string line;
     while (std::getline(data, line)) {
+        TRACE_MESSAGE("TradeBookingConnector::Subscribe");
         std::stringstream lineStream(line);
         std::vector<std::string> tokens;
         std::string token;
@@ -238,9 +460,23 @@ void TradeBookingConnector<T>::Subscribe(std::ifstream& data) {
         const std::string& book = tokens[3];
         long quantity = std::stol(tokens[4]);
         Side side = (tokens[5] == "BUY") ? BUY : SELL;
+        long long eventTime = tokens.size() > 6 ? TimeUtils::ParseTimeNanos(tokens[6]) : 0;
+        if (eventClock != nullptr && eventTime != 0) {
+            eventClock->Advance(eventTime);
+        }
+        if (timers != nullptr) {
+            timers->Poll();
+        }
 
-        Trade<T> trade(product, tradeId, price, book, quantity, side);
-        service->OnMessage(trade);
+        Trade<T> trade(product, tradeId, price, book, quantity, side, eventTime);
+        const std::string action = tokens.size() > 7 ? tokens[7] : "NEW";
+        if (action == "AMEND") {
+            service->AmendTrade(trade);
+        } else if (action == "CANCEL") {
+            service->CancelTrade(tradeId, eventTime);
+        } else {
+            service->OnMessage(trade);
+        }
     }
 }
 
@@ -276,7 +512,7 @@ void TradeBookingServiceListener<T>::ProcessAdd(ExecutionOrder<T>& order) {
 
     const std::string book = "TRSY" + std::to_string(count++ % 3 + 1);
 
-    Trade<T> trade(product, orderId, price, book, totalQuantity, tradeSide);
+    Trade<T> trade(product, orderId, price, book, totalQuantity, tradeSide, order.GetEventTime());
     service->BookTrade(trade);
 }
 